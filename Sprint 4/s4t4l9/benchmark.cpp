@@ -0,0 +1,1283 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <execution>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "compressed_postings.h"
+#include "concurrent_search_server.h"
+#include "document_predicates.h"
+#include "log_duration.h"
+#include "mapped_search_server.h"
+#include "position_list.h"
+#include "posting_intersection.h"
+#include "posting_list.h"
+#include "process_queries.h"
+#include "query.h"
+#include "query_result_cache.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "term_dictionary.h"
+#include "term_hash_map.h"
+
+// Проверка результата бенчмарка. В отличие от assert проверяет и в сборке с NDEBUG,
+// в которой обычно и меряют производительность
+#define BENCHMARK_CHECK(condition) CheckBenchmarkCondition((condition), #condition, __FILE__, __LINE__)
+
+namespace {
+
+void CheckBenchmarkCondition(bool condition, const char* expression, const char* file, int line) {
+    if (!condition) {
+        std::cerr << file << ':' << line << ": benchmark check failed: " << expression << std::endl;
+        std::abort();
+    }
+}
+
+// Ресурс памяти, считающий выделения. Стоит вышестоящим у буфера запроса,
+// поэтому видит только выделения, не уместившиеся в буфер на стеке
+class CountingMemoryResource : public std::pmr::memory_resource {
+    public:
+        std::size_t GetAllocationCount() const {
+            return allocation_count_;
+        }
+
+    private:
+        std::pmr::memory_resource* upstream_ = std::pmr::new_delete_resource();
+        std::size_t allocation_count_ = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocation_count_;
+            return upstream_->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+            upstream_->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+};
+
+// Прежний токенизатор: слово собирается посимвольно в новую строку
+std::vector<std::string> SplitIntoWordsCopying(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (const char c : text) {
+        if (c == ' ') {
+            if (!word.empty()) {
+                words.push_back(word);
+                word.clear();
+            }
+        } else {
+            word += c;
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Итог смешанной нагрузки: сколько выполнено запросов и добавлений и 99-й перцентиль задержки запроса
+struct MixedWorkloadStats {
+    std::size_t query_count = 0;
+    std::size_t write_count = 0;
+    std::chrono::microseconds p99_query_latency{0};
+};
+
+// Один писатель добавляет документы, reader_count читателей все это время выполняют запросы
+template <typename AddDocument, typename FindTopDocuments>
+MixedWorkloadStats RunMixedWorkload(AddDocument add_document, FindTopDocuments find_top_documents,
+    const std::vector<std::string>& queries, std::size_t write_count, int reader_count) {
+
+    std::atomic<bool> is_writing{true};
+    std::vector<std::vector<std::chrono::microseconds>> latencies(static_cast<std::size_t>(reader_count));
+    std::vector<std::thread> readers;
+    for (std::size_t reader = 0; reader < latencies.size(); ++reader) {
+        readers.emplace_back([&, reader] {
+            for (std::size_t i = reader; is_writing; i = (i + 1) % queries.size()) {
+                const auto start = std::chrono::steady_clock::now();
+                find_top_documents(queries[i]);
+                latencies[reader].push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start));
+            }
+        });
+    }
+    for (std::size_t i = 0; i < write_count; ++i) {
+        add_document(i);
+    }
+    is_writing = false;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::vector<std::chrono::microseconds> all_latencies;
+    for (const auto& reader_latencies : latencies) {
+        all_latencies.insert(all_latencies.end(), reader_latencies.begin(), reader_latencies.end());
+    }
+    MixedWorkloadStats stats;
+    stats.query_count = all_latencies.size();
+    stats.write_count = write_count;
+    if (!all_latencies.empty()) {
+        const auto p99 = all_latencies.begin() + static_cast<std::ptrdiff_t>(all_latencies.size() * 99 / 100);
+        std::nth_element(all_latencies.begin(), p99, all_latencies.end());
+        stats.p99_query_latency = *p99;
+    }
+    return stats;
+}
+
+} // namespace
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(static_cast<std::size_t>(length));
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(static_cast<std::size_t>(word_count));
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int word_count, double minus_prob) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[static_cast<std::size_t>(
+            std::uniform_int_distribution<int>(0, static_cast<int>(dictionary.size()) - 1)(generator))];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(static_cast<std::size_t>(query_count));
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int word_count, double exponent) {
+    std::vector<double> weights(dictionary.size());
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / std::pow(static_cast<double>(i) + 1.0, exponent);
+    }
+    std::discrete_distribution<std::size_t> word_distribution(weights.begin(), weights.end());
+
+    std::vector<std::string> queries;
+    queries.reserve(static_cast<std::size_t>(query_count));
+    for (int i = 0; i < query_count; ++i) {
+        std::string query;
+        for (int j = 0; j < word_count; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += dictionary[word_distribution(generator)];
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
+// Сравнение последовательного и параллельного FindTopDocuments
+void BenchmarkParallelFindTopDocuments() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 50, 70);
+
+    std::vector<std::vector<Document>> seq_results;
+    std::vector<std::vector<Document>> par_results;
+    {
+        LOG_DURATION("FindTopDocuments seq");
+        for (const std::string& query : queries) {
+            seq_results.push_back(search_server.FindTopDocuments(std::execution::seq, query));
+        }
+    }
+    {
+        LOG_DURATION("FindTopDocuments par");
+        for (const std::string& query : queries) {
+            par_results.push_back(search_server.FindTopDocuments(std::execution::par, query));
+        }
+    }
+
+    // Результаты обеих версий должны совпадать побитово
+    for (size_t i = 0; i < queries.size(); ++i) {
+        BENCHMARK_CHECK(seq_results[i].size() == par_results[i].size());
+        for (size_t j = 0; j < seq_results[i].size(); ++j) {
+            BENCHMARK_CHECK(seq_results[i][j].id == par_results[i][j].id);
+            BENCHMARK_CHECK(seq_results[i][j].relevance == par_results[i][j].relevance);
+        }
+    }
+}
+
+
+// Сравнение пакетной обработки запросов с последовательными вызовами FindTopDocuments
+void BenchmarkProcessQueries() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 25);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
+
+    std::size_t sequential_count = 0;
+    {
+        LOG_DURATION("FindTopDocuments loop");
+        for (const std::string& query : queries) {
+            sequential_count += search_server.FindTopDocuments(query).size();
+        }
+    }
+    {
+        LOG_DURATION("ProcessQueries");
+        const auto results = ProcessQueries(search_server, queries);
+        BENCHMARK_CHECK(results.size() == queries.size());
+    }
+    {
+        LOG_DURATION("ProcessQueriesJoined");
+        std::size_t joined_count = 0;
+        for ([[maybe_unused]] const Document& document : ProcessQueriesJoined(search_server, queries)) {
+            ++joined_count;
+        }
+        BENCHMARK_CHECK(joined_count == sequential_count);
+    }
+}
+
+// Сравнение обхода и объема списков вхождений: map<string, map<int, double>> против PostingList
+void BenchmarkPostingLists() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 30);
+
+    std::map<std::string, std::map<int, double>> word_to_document_freqs;
+    std::map<std::string, TermId> term_ids;
+    std::vector<PostingList> postings;
+    std::size_t entry_count = 0;
+
+    for (size_t i = 0; i < documents.size(); ++i) {
+        for (const std::string_view word : SplitIntoWords(documents[i])) {
+            word_to_document_freqs[std::string(word)][static_cast<int>(i)] += 1.0;
+            const auto [it, inserted] = term_ids.emplace(std::string(word), static_cast<TermId>(postings.size()));
+            if (inserted) {
+                postings.emplace_back();
+            }
+            postings[it->second].Add(static_cast<DocumentOrdinal>(i), 1.0);
+        }
+    }
+    for (const PostingList& term_postings : postings) {
+        entry_count += term_postings.size();
+    }
+
+    const int pass_count = 5;
+    double map_sum = 0;
+    double flat_sum = 0;
+    {
+        LOG_DURATION("Posting traversal map");
+        for (int pass = 0; pass < pass_count; ++pass) {
+            for (const auto& [word, document_freqs] : word_to_document_freqs) {
+                for (const auto& [document_id, term_freq] : document_freqs) {
+                    map_sum += term_freq * document_id;
+                }
+            }
+        }
+    }
+    {
+        LOG_DURATION("Posting traversal flat");
+        for (int pass = 0; pass < pass_count; ++pass) {
+            for (const PostingList& term_postings : postings) {
+                for (std::size_t i = 0; i < term_postings.size(); ++i) {
+                    flat_sum += term_postings.term_freqs[i] * term_postings.document_ordinals[i];
+                }
+            }
+        }
+    }
+    BENCHMARK_CHECK(map_sum == flat_sum);
+
+    // Те же списки в сжатом виде снимка: частоты здесь - целые колличества вхождений
+    std::vector<std::uint64_t> block_offsets = {0};
+    std::vector<PostingBlock> blocks;
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint32_t> term_counts;
+    for (const PostingList& term_postings : postings) {
+        term_counts.assign(term_postings.term_freqs.begin(), term_postings.term_freqs.end());
+        EncodePostings(term_postings.document_ordinals.data(), term_counts.data(), term_postings.size(), blocks, data);
+        block_offsets.push_back(blocks.size());
+    }
+    double compressed_sum = 0;
+    {
+        LOG_DURATION("Posting traversal compressed");
+        for (int pass = 0; pass < pass_count; ++pass) {
+            for (std::size_t term = 0; term < postings.size(); ++term) {
+                const CompressedPostings term_postings(blocks.data() + block_offsets[term],
+                    block_offsets[term + 1] - block_offsets[term], data.data());
+                term_postings.ForEach(0, static_cast<DocumentOrdinal>(documents.size()),
+                    [&compressed_sum](DocumentOrdinal ordinal, std::uint32_t term_count) {
+                        compressed_sum += static_cast<double>(term_count) * ordinal;
+                    });
+            }
+        }
+    }
+    BENCHMARK_CHECK(flat_sum == compressed_sum);
+
+    // Узел красно-черного дерева libstdc++: цвет (с выравниванием) и три указателя плюс значение
+    const std::size_t map_node_overhead = 4 * sizeof(void*);
+    const std::size_t map_entry_bytes = map_node_overhead + sizeof(std::pair<const int, double>);
+    const std::size_t flat_entry_bytes = sizeof(DocumentOrdinal) + sizeof(double);
+    const double compressed_entry_bytes = static_cast<double>(blocks.size() * sizeof(PostingBlock) + data.size())
+        / static_cast<double>(entry_count);
+    std::cerr << "Postings: " << entry_count << " entries, map ~" << map_entry_bytes
+              << " bytes/entry, flat " << flat_entry_bytes << " bytes/entry, compressed "
+              << compressed_entry_bytes << " bytes/entry" << std::endl;
+}
+
+// Сравнение токенизатора на string_view с посимвольным копированием слов
+// и подсчет выделений памяти при разборе запроса
+void BenchmarkQueryParsing() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 20);
+    std::vector<std::string> queries;
+    for (int i = 0; i < 100'000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, 10, 0.2));
+    }
+    const std::set<std::string, std::less<>> stop_words = {dictionary[0], dictionary[1]};
+
+    std::size_t copying_word_count = 0;
+    std::size_t view_word_count = 0;
+    {
+        LOG_DURATION("SplitIntoWords copying");
+        for (const std::string& query : queries) {
+            copying_word_count += SplitIntoWordsCopying(query).size();
+        }
+    }
+    {
+        LOG_DURATION("ForEachWord string_view");
+        for (const std::string& query : queries) {
+            ForEachWord(query, [&view_word_count](std::string_view) {
+                ++view_word_count;
+            });
+        }
+    }
+    BENCHMARK_CHECK(copying_word_count == view_word_count);
+
+    std::size_t parsed_word_count = 0;
+    CountingMemoryResource counting_resource;
+    {
+        LOG_DURATION("ParseQuery with stack buffer");
+        for (const std::string& query : queries) {
+            // Тот же буфер, что в QueryBuffer, но переполнение уходит в считающий ресурс
+            std::array<std::byte, QUERY_BUFFER_SIZE> data;
+            std::pmr::monotonic_buffer_resource resource(data.data(), data.size(), &counting_resource);
+            const Query parsed = ParseQuery(query, stop_words, &resource);
+            parsed_word_count += parsed.plus_words.size() + parsed.minus_words.size();
+        }
+    }
+    std::cerr << "ParseQuery: " << parsed_word_count << " words, "
+              << counting_resource.GetAllocationCount() << " heap allocations" << std::endl;
+}
+
+// Поиск по запросам с большим числом минус-слов
+void BenchmarkMinusWords() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 30);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    std::vector<std::string> plus_queries;
+    std::vector<std::string> minus_queries;
+    for (int i = 0; i < 500; ++i) {
+        plus_queries.push_back(GenerateQuery(generator, dictionary, 10));
+        // Те же 10 плюс-слов и около 20 минус-слов
+        minus_queries.push_back(plus_queries.back() + " " + GenerateQuery(generator, dictionary, 20, 1.0));
+    }
+
+    std::size_t plus_count = 0;
+    std::size_t minus_count = 0;
+    {
+        LOG_DURATION("Queries without minus words");
+        for (const std::string& query : plus_queries) {
+            plus_count += search_server.FindTopDocuments(query).size();
+        }
+    }
+    {
+        LOG_DURATION("Queries with 20 minus words");
+        for (const std::string& query : minus_queries) {
+            minus_count += search_server.FindTopDocuments(query).size();
+        }
+    }
+    BENCHMARK_CHECK(minus_count <= plus_count);
+}
+
+// Сравнение холодного старта: индексация текстов против загрузки бинарного снимка
+void BenchmarkSnapshot() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 7);
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server.snapshot").string();
+
+    std::vector<std::vector<Document>> expected;
+    {
+        LOG_DURATION("Cold start from texts");
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        for (const std::string& query : queries) {
+            expected.push_back(search_server.FindTopDocuments(query));
+        }
+        search_server.SaveSnapshot(path);
+    }
+
+    std::vector<std::vector<Document>> loaded;
+    {
+        LOG_DURATION("Cold start from snapshot");
+        const SearchServer search_server = SearchServer::LoadSnapshot(path);
+        for (const std::string& query : queries) {
+            loaded.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+    std::remove(path.c_str());
+
+    BENCHMARK_CHECK(expected.size() == loaded.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BENCHMARK_CHECK(expected[i].size() == loaded[i].size());
+        for (size_t j = 0; j < expected[i].size(); ++j) {
+            BENCHMARK_CHECK(expected[i][j].id == loaded[i][j].id);
+            BENCHMARK_CHECK(expected[i][j].relevance == loaded[i][j].relevance);
+        }
+    }
+}
+
+// Запросы к снимку, отображенному в память, против загруженного в кучу индекса
+void BenchmarkMappedSnapshot() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server.snapshot").string();
+
+    {
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        search_server.SaveSnapshot(path);
+    }
+
+    std::vector<std::vector<Document>> expected;
+    {
+        LOG_DURATION("Loaded snapshot: open and query");
+        const SearchServer search_server = SearchServer::LoadSnapshot(path);
+        for (const std::string& query : queries) {
+            expected.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+
+    std::vector<std::vector<Document>> mapped;
+    {
+        LOG_DURATION("Mapped snapshot: open and query");
+        const MappedSearchServer search_server(path);
+        for (const std::string& query : queries) {
+            mapped.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+    std::remove(path.c_str());
+
+    BENCHMARK_CHECK(expected.size() == mapped.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BENCHMARK_CHECK(expected[i].size() == mapped[i].size());
+        for (size_t j = 0; j < expected[i].size(); ++j) {
+            BENCHMARK_CHECK(expected[i][j].id == mapped[i][j].id);
+            BENCHMARK_CHECK(expected[i][j].relevance == mapped[i][j].relevance);
+        }
+    }
+}
+
+// Параллельная индексация в шардированный сервер против последовательной в один SearchServer
+void BenchmarkShardedSearchServer() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 500, 7);
+
+    SearchServer search_server(dictionary[0]);
+    {
+        LOG_DURATION("Single server: sequential AddDocument");
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+    }
+
+    ShardedSearchServer sharded_search_server(dictionary[0]);
+    std::vector<int> document_ids(documents.size());
+    std::iota(document_ids.begin(), document_ids.end(), 0);
+    {
+        LOG_DURATION("Sharded server: parallel AddDocument");
+        std::for_each(std::execution::par, document_ids.begin(), document_ids.end(), [&](int document_id) {
+            sharded_search_server.AddDocument(document_id, documents[static_cast<std::size_t>(document_id)],
+                DocumentStatus::ACTUAL, {1, 2, 3});
+        });
+    }
+    BENCHMARK_CHECK(sharded_search_server.GetDocumentCount() == search_server.GetDocumentCount());
+
+    std::vector<std::vector<Document>> expected;
+    {
+        LOG_DURATION("Single server: queries");
+        for (const std::string& query : queries) {
+            expected.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+    std::vector<std::vector<Document>> sharded;
+    {
+        LOG_DURATION("Sharded server: parallel fan-out queries");
+        for (const std::string& query : queries) {
+            sharded.push_back(sharded_search_server.FindTopDocuments(std::execution::par, query));
+        }
+    }
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+        BENCHMARK_CHECK(expected[i].size() == sharded[i].size());
+        for (size_t j = 0; j < expected[i].size(); ++j) {
+            BENCHMARK_CHECK(expected[i][j].id == sharded[i][j].id);
+            BENCHMARK_CHECK(expected[i][j].relevance == sharded[i][j].relevance);
+        }
+    }
+}
+
+// Смешанная нагрузка: добавление документов во время запросов. Сервер под общим мьютексом
+// против ConcurrentSearchServer. Заодно проверяется, что читатели видят согласованные версии индекса
+void BenchmarkConcurrentSearchServer() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 4'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 200, 7);
+    const std::size_t initial_count = documents.size() / 2;
+    const int reader_count = 2;
+
+    SearchServer locked_search_server(dictionary[0]);
+    std::mutex search_server_mutex;
+    ConcurrentSearchServer concurrent_search_server(dictionary[0]);
+    for (size_t i = 0; i < initial_count; ++i) {
+        locked_search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        concurrent_search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto print_stats = [](const std::string& name, const MixedWorkloadStats& stats) {
+        std::cerr << name << ": " << stats.query_count << " queries, " << stats.write_count << " writes, p99 query latency "
+            << stats.p99_query_latency.count() << " us" << std::endl;
+    };
+
+    {
+        LOG_DURATION("Mutex-guarded SearchServer: mixed load");
+        print_stats("Mutex-guarded SearchServer", RunMixedWorkload(
+            [&](std::size_t i) {
+                const std::lock_guard lock(search_server_mutex);
+                locked_search_server.AddDocument(static_cast<int>(initial_count + i), documents[initial_count + i],
+                    DocumentStatus::ACTUAL, {1, 2, 3});
+            },
+            [&](const std::string& query) {
+                const std::lock_guard lock(search_server_mutex);
+                locked_search_server.FindTopDocuments(query);
+            },
+            queries, documents.size() - initial_count, reader_count));
+    }
+    {
+        LOG_DURATION("ConcurrentSearchServer: mixed load");
+        print_stats("ConcurrentSearchServer", RunMixedWorkload(
+            [&](std::size_t i) {
+                concurrent_search_server.AddDocument(static_cast<int>(initial_count + i), documents[initial_count + i],
+                    DocumentStatus::ACTUAL, {1, 2, 3});
+            },
+            [&](const std::string& query) {
+                // Читатель видит только целиком опубликованные версии: число документов не убывает,
+                // а найденные документы уже добавлены
+                static thread_local int last_document_count = 0;
+                const int document_count = concurrent_search_server.GetDocumentCount();
+                BENCHMARK_CHECK(document_count >= last_document_count);
+                last_document_count = document_count;
+                for (const Document& document : concurrent_search_server.FindTopDocuments(query)) {
+                    BENCHMARK_CHECK(document.id >= 0 && static_cast<std::size_t>(document.id) < documents.size());
+                }
+            },
+            queries, documents.size() - initial_count, reader_count));
+    }
+
+    // После всех добавлений и удалений выдача совпадает с обычным сервером: и пока удаленные документы
+    // только помечены, и после того, как фоновое слияние их выбросило
+    for (size_t i = 0; i < documents.size(); i += 10) {
+        locked_search_server.RemoveDocument(static_cast<int>(i));
+        concurrent_search_server.RemoveDocument(static_cast<int>(i));
+    }
+    const auto check_results = [&] {
+        BENCHMARK_CHECK(concurrent_search_server.GetDocumentCount() == locked_search_server.GetDocumentCount());
+        for (const std::string& query : queries) {
+            const auto expected = locked_search_server.FindTopDocuments(query);
+            const auto concurrent = concurrent_search_server.FindTopDocuments(query);
+            BENCHMARK_CHECK(expected.size() == concurrent.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                BENCHMARK_CHECK(expected[i].id == concurrent[i].id);
+                BENCHMARK_CHECK(expected[i].relevance == concurrent[i].relevance);
+            }
+        }
+    };
+    check_results();
+    concurrent_search_server.Flush();
+    std::cerr << "ConcurrentSearchServer: " << concurrent_search_server.GetSegmentCount() << " segments after flush"
+        << std::endl;
+    check_results();
+}
+
+// Пакетное добавление документов против поштучного AddDocument
+void BenchmarkAddDocuments() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto texts = GenerateQueries(generator, dictionary, 20'000, 50);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 7);
+
+    std::vector<DocumentToAdd> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    const auto print_rate = [&](const std::string& name, std::chrono::steady_clock::duration duration) {
+        const double seconds = std::chrono::duration<double>(duration).count();
+        std::cerr << name << ": " << static_cast<std::size_t>(static_cast<double>(documents.size()) / seconds)
+            << " docs/sec" << std::endl;
+    };
+
+    // Те же замеры с позиционным индексом: части пакета собирают и позиции слов
+    for (const bool with_positions : {false, true}) {
+        const std::string suffix = with_positions ? " with positions" : "";
+        const auto make_search_server = [&] {
+            SearchServer search_server(dictionary[0]);
+            if (with_positions) {
+                search_server.EnablePositions();
+            }
+            return search_server;
+        };
+
+        SearchServer search_server = make_search_server();
+        auto start = std::chrono::steady_clock::now();
+        for (const DocumentToAdd& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        print_rate("AddDocument" + suffix, std::chrono::steady_clock::now() - start);
+
+        SearchServer seq_search_server = make_search_server();
+        start = std::chrono::steady_clock::now();
+        seq_search_server.AddDocuments(std::execution::seq, documents);
+        print_rate("AddDocuments seq" + suffix, std::chrono::steady_clock::now() - start);
+
+        SearchServer par_search_server = make_search_server();
+        start = std::chrono::steady_clock::now();
+        par_search_server.AddDocuments(std::execution::par, documents);
+        print_rate("AddDocuments par" + suffix, std::chrono::steady_clock::now() - start);
+
+        for (const std::string& query : queries) {
+            const auto expected = search_server.FindTopDocuments(query);
+            for (const SearchServer* batch_search_server : {&seq_search_server, &par_search_server}) {
+                const auto found = batch_search_server->FindTopDocuments(query);
+                BENCHMARK_CHECK(expected.size() == found.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    BENCHMARK_CHECK(expected[i].id == found[i].id);
+                    BENCHMARK_CHECK(expected[i].relevance == found[i].relevance);
+                }
+            }
+        }
+    }
+}
+
+// Полный перебор против MaxScore на длинных запросах по словам с распределением Ципфа
+void BenchmarkMaxScore() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateZipfQueries(generator, dictionary, 20'000, 30);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 10)});
+    }
+
+    const auto queries = GenerateZipfQueries(generator, dictionary, 50, 30);
+
+    std::vector<std::vector<Document>> exhaustive_results;
+    std::vector<std::vector<Document>> max_score_results;
+    {
+        LOG_DURATION("FindTopDocuments exhaustive, 30-word OR queries");
+        for (const std::string& query : queries) {
+            exhaustive_results.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+    search_server.SetQueryEvaluation(QueryEvaluation::MAX_SCORE);
+    {
+        LOG_DURATION("FindTopDocuments MaxScore, 30-word OR queries");
+        for (const std::string& query : queries) {
+            max_score_results.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+
+    // Отсечение не должно менять выдачу
+    for (size_t i = 0; i < queries.size(); ++i) {
+        BENCHMARK_CHECK(exhaustive_results[i].size() == max_score_results[i].size());
+        for (size_t j = 0; j < exhaustive_results[i].size(); ++j) {
+            BENCHMARK_CHECK(exhaustive_results[i][j].id == max_score_results[i][j].id);
+            BENCHMARK_CHECK(exhaustive_results[i][j].relevance == max_score_results[i][j].relevance);
+        }
+    }
+}
+
+// Поток повторяющихся запросов с распределением Ципфа: SearchServer против кэша выдачи
+void BenchmarkQueryResultCache() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 20);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Запрос из одного "слова" набора - один из 2000 различных запросов
+    const auto distinct_queries = GenerateQueries(generator, dictionary, 2'000, 5);
+    const auto queries = GenerateZipfQueries(generator, distinct_queries, 20'000, 1);
+
+    std::vector<std::vector<Document>> server_results(queries.size());
+    std::vector<std::vector<Document>> cache_results(queries.size());
+    std::vector<std::size_t> indexes(queries.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    {
+        LOG_DURATION("SearchServer: Zipfian query stream");
+        std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](std::size_t i) {
+            server_results[i] = search_server.FindTopDocuments(queries[i]);
+        });
+    }
+    QueryResultCache query_result_cache(search_server, 1'024);
+    {
+        LOG_DURATION("QueryResultCache: Zipfian query stream");
+        std::for_each(std::execution::par, indexes.begin(), indexes.end(), [&](std::size_t i) {
+            cache_results[i] = query_result_cache.FindTopDocuments(queries[i]);
+        });
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        BENCHMARK_CHECK(server_results[i].size() == cache_results[i].size());
+        for (size_t j = 0; j < server_results[i].size(); ++j) {
+            BENCHMARK_CHECK(server_results[i][j].id == cache_results[i][j].id);
+            BENCHMARK_CHECK(server_results[i][j].relevance == cache_results[i][j].relevance);
+        }
+    }
+
+    // После изменения индекса записи старого поколения не выдаются
+    const auto top_query = std::find_if(indexes.begin(), indexes.end(), [&](std::size_t i) {
+        return !server_results[i].empty();
+    });
+    if (top_query != indexes.end()) {
+        const int removed_document_id = server_results[*top_query].front().id;
+        search_server.RemoveDocument(removed_document_id);
+        for (const Document& document : query_result_cache.FindTopDocuments(queries[*top_query])) {
+            BENCHMARK_CHECK(document.id != removed_document_id);
+        }
+    }
+
+    const QueryResultCacheStats stats = query_result_cache.GetStats();
+    std::cerr << "QueryResultCache: " << stats.hits << " hits, " << stats.misses << " misses, "
+        << stats.evictions << " evictions, " << stats.invalidations << " invalidations" << std::endl;
+}
+
+// Поиск с фильтром по каждому статусу и с предикатом по рейтингу
+void BenchmarkStatusFilters() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 40'000, 30);
+
+    // Статусы распределены неравномерно, как в рабочем индексе: большинство документов актуальны
+    const std::vector<DocumentStatus> statuses = {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT,
+        DocumentStatus::BANNED, DocumentStatus::REMOVED};
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentStatus status = i % 10 < 7 ? DocumentStatus::ACTUAL : statuses[i % 10 - 6];
+        search_server.AddDocument(static_cast<int>(i), documents[i], status, {static_cast<int>(i % 10)});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 300, 10);
+    const std::vector<std::string> status_names = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+    for (std::size_t status = 0; status < statuses.size(); ++status) {
+        std::size_t found_count = 0;
+        {
+            LOG_DURATION("FindTopDocuments status " + status_names[status]);
+            for (const std::string& query : queries) {
+                found_count += search_server.FindTopDocuments(query, statuses[status]).size();
+            }
+        }
+        BENCHMARK_CHECK(found_count > 0);
+    }
+    {
+        LOG_DURATION("FindTopDocuments rating predicate");
+        for (const std::string& query : queries) {
+            search_server.FindTopDocuments(query, [](int, DocumentStatus, int rating) {
+                return rating >= 5;
+            });
+        }
+    }
+}
+
+namespace {
+
+// Время поиска по всем запросам с предикатом и суммарное число найденных документов
+template <typename DocumentPredicate>
+std::size_t RunFilteredQueries(const std::string& name, const SearchServer& search_server,
+    const std::vector<std::string>& queries, DocumentPredicate document_predicate) {
+    std::size_t found_count = 0;
+    LOG_DURATION(name);
+    for (const std::string& query : queries) {
+        found_count += search_server.FindTopDocuments(query, document_predicate).size();
+    }
+    return found_count;
+}
+
+} // namespace
+
+// Предикаты-лямбды против предикатов из document_predicates.h, которые SearchServer сводит к маске
+void BenchmarkDocumentPredicates() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 40'000, 30);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const auto status = static_cast<DocumentStatus>(i % 4);
+        search_server.AddDocument(static_cast<int>(i), documents[i], status, {static_cast<int>(i % 10)});
+    }
+
+    const auto queries = GenerateQueries(generator, dictionary, 300, 10);
+    std::vector<int> document_ids;
+    for (int i = 0; i < 1'000; ++i) {
+        document_ids.push_back(std::uniform_int_distribution<int>(0, static_cast<int>(documents.size()) - 1)(generator));
+    }
+    const std::set<int> document_id_set(document_ids.begin(), document_ids.end());
+
+    const std::size_t lambda_status = RunFilteredQueries("Lambda status", search_server, queries,
+        [](int, DocumentStatus status, int) { return status == DocumentStatus::BANNED; });
+    const std::size_t filter_status = RunFilteredQueries("ByStatus", search_server, queries,
+        ByStatus{DocumentStatus::BANNED});
+    BENCHMARK_CHECK(lambda_status == filter_status);
+
+    const std::size_t lambda_rating = RunFilteredQueries("Lambda rating range", search_server, queries,
+        [](int, DocumentStatus, int rating) { return 3 <= rating && rating <= 5; });
+    const std::size_t filter_rating = RunFilteredQueries("RatingRange", search_server, queries, RatingRange{3, 5});
+    BENCHMARK_CHECK(lambda_rating == filter_rating);
+
+    const std::size_t lambda_ids = RunFilteredQueries("Lambda ID set", search_server, queries,
+        [&document_id_set](int document_id, DocumentStatus, int) {
+            return document_id_set.count(document_id) > 0;
+        });
+    const std::size_t filter_ids = RunFilteredQueries("IdSet", search_server, queries, IdSet(document_ids));
+    BENCHMARK_CHECK(lambda_ids == filter_ids);
+
+    const std::size_t lambda_combined = RunFilteredQueries("Lambda status && rating range", search_server, queries,
+        [](int, DocumentStatus status, int rating) {
+            return status == DocumentStatus::ACTUAL && 3 <= rating && rating <= 5;
+        });
+    const std::size_t filter_combined = RunFilteredQueries("ByStatus && RatingRange", search_server, queries,
+        ByStatus{DocumentStatus::ACTUAL} && RatingRange{3, 5});
+    BENCHMARK_CHECK(lambda_combined == filter_combined);
+}
+
+// Фразы и NEAR/k против тех же слов без ограничений
+void BenchmarkPhraseQueries() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 50);
+
+    SearchServer plain_server(dictionary[0]);
+    {
+        LOG_DURATION("AddDocument without positions");
+        for (size_t i = 0; i < documents.size(); ++i) {
+            plain_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+        }
+    }
+    SearchServer positional_server(dictionary[0]);
+    positional_server.EnablePositions();
+    {
+        LOG_DURATION("AddDocument with positions");
+        for (size_t i = 0; i < documents.size(); ++i) {
+            positional_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+        }
+    }
+
+    // Те же позиции, что записывает SearchServer: номер слова документа без стоп-слов
+    std::map<std::string_view, PositionList> positions;
+    std::size_t position_count = 0;
+    for (const std::string& document : documents) {
+        std::map<std::string_view, bool> seen;
+        std::uint32_t position = 0;
+        for (const std::string_view word : SplitIntoWords(document)) {
+            if (word == dictionary[0]) {
+                continue;
+            }
+            positions[word].Add(seen.emplace(word, true).second, position++);
+            ++position_count;
+        }
+    }
+    std::size_t position_bytes = 0;
+    for (const auto& [word, word_positions] : positions) {
+        position_bytes += word_positions.GetByteSize();
+    }
+    std::cerr << "Positions: " << position_count << " positions, "
+        << static_cast<double>(position_bytes) / static_cast<double>(position_count) << " bytes/position" << std::endl;
+
+    // Пары соседних слов документов, чтобы у фраз были совпадения
+    std::vector<std::string> plain_queries;
+    std::vector<std::string> phrase_queries;
+    std::vector<std::string> near_queries;
+    while (plain_queries.size() < 500) {
+        const auto words = SplitIntoWords(documents[std::uniform_int_distribution<size_t>(0, documents.size() - 1)(generator)]);
+        const size_t begin = std::uniform_int_distribution<size_t>(0, words.size() - 2)(generator);
+        if (words[begin] == dictionary[0] || words[begin + 1] == dictionary[0]) {
+            continue;
+        }
+        const std::string pair = std::string(words[begin]) + ' ' + std::string(words[begin + 1]);
+        plain_queries.push_back(pair);
+        phrase_queries.push_back('"' + pair + '"');
+        near_queries.push_back(std::string(words[begin]) + " NEAR/3 " + std::string(words[begin + 1]));
+    }
+
+    const auto run_queries = [&positional_server](const std::string& name, const std::vector<std::string>& queries) {
+        std::size_t found_count = 0;
+        LOG_DURATION(name);
+        for (const std::string& query : queries) {
+            found_count += positional_server.FindTopDocuments(query).size();
+        }
+        return found_count;
+    };
+    const std::size_t plain_found = run_queries("Plain two-word queries", plain_queries);
+    const std::size_t phrase_found = run_queries("Phrase queries", phrase_queries);
+    const std::size_t near_found = run_queries("NEAR/3 queries", near_queries);
+    std::cerr << "Found: plain " << plain_found << ", phrase " << phrase_found << ", NEAR/3 " << near_found << std::endl;
+    BENCHMARK_CHECK(phrase_found > 0 && phrase_found <= near_found && near_found <= plain_found);
+}
+
+// Раскрытие префиксов и объединение списков вхождений
+void BenchmarkPrefixQueries() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 50'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 30);
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+    }
+
+    std::map<std::string_view, TermId> term_ids;
+    std::size_t term_bytes = 0;
+    for (const std::string& word : dictionary) {
+        term_ids.emplace(word, static_cast<TermId>(term_ids.size()));
+        term_bytes += word.size();
+    }
+    TermDictionary term_dictionary;
+    term_dictionary.RefreshIfStale(dictionary);
+    // Узел красно-черного дерева - цвет и три указателя, 32 байта на 64-битной платформе
+    const std::size_t map_bytes = term_ids.size() * (32 + sizeof(std::pair<const std::string_view, TermId>));
+    std::cerr << "Term dictionary: " << term_ids.size() << " terms, " << term_bytes << " bytes of text, "
+        << map_bytes << " bytes of std::map nodes, " << term_dictionary.GetByteSize() << " bytes front-coded"
+        << std::endl;
+
+    // Префиксы из двух-трех букв начала случайных слов словаря
+    std::vector<std::string> prefixes;
+    for (int i = 0; i < 20'000; ++i) {
+        const std::string& word = dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        prefixes.push_back(word.substr(0, std::uniform_int_distribution<size_t>(2, 3)(generator)));
+    }
+
+    std::size_t map_expansions = 0;
+    {
+        LOG_DURATION("Prefix expansion over std::map");
+        for (const std::string& prefix : prefixes) {
+            for (auto it = term_ids.lower_bound(prefix);
+                it != term_ids.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+                map_expansions += it->second % 2 + 1;
+            }
+        }
+    }
+    std::size_t dictionary_expansions = 0;
+    {
+        LOG_DURATION("Prefix expansion over front-coded dictionary");
+        for (const std::string& prefix : prefixes) {
+            term_dictionary.ForEachTermWithPrefix(prefix, [&dictionary_expansions](TermId term_id) {
+                dictionary_expansions += term_id % 2 + 1;
+                return true;
+            });
+        }
+    }
+    BENCHMARK_CHECK(map_expansions == dictionary_expansions);
+
+    // Запросы из обычного слова и префикса, префиксы из одной буквы раскрываются в тысячи слов
+    std::vector<std::string> queries;
+    for (int i = 0; i < 200; ++i) {
+        const std::string& word = dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        const std::string& prefix = prefixes[std::uniform_int_distribution<size_t>(0, prefixes.size() - 1)(generator)];
+        queries.push_back(word + ' ' + prefix.substr(0, i % 4 == 0 ? 1 : prefix.size()) + '*');
+    }
+    for (const std::size_t max_expansions : std::array<std::size_t, 4>{16, 64, 1'024, 100'000}) {
+        search_server.SetMaxPrefixExpansions(max_expansions);
+        std::size_t found_count = 0;
+        {
+            LOG_DURATION("Prefix queries, max " + std::to_string(max_expansions) + " expansions");
+            for (const std::string& query : queries) {
+                found_count += search_server.FindTopDocuments(query).size();
+            }
+        }
+        std::cerr << "Found: " << found_count << std::endl;
+    }
+}
+
+// TF-IDF против BM25 при полном переборе и MaxScore
+void BenchmarkRelevanceModels() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    // Длины документов от 5 до 60 слов, чтобы норма длины в BM25 влияла на выдачу
+    std::vector<std::string> documents;
+    for (int i = 0; i < 40'000; ++i) {
+        documents.push_back(GenerateQuery(generator, dictionary, std::uniform_int_distribution(5, 60)(generator)));
+    }
+
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+    }
+
+    const auto queries = GenerateZipfQueries(generator, dictionary, 300, 10);
+    for (const QueryEvaluation evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        search_server.SetQueryEvaluation(evaluation);
+        const std::string evaluation_name = evaluation == QueryEvaluation::EXHAUSTIVE ? "exhaustive" : "MaxScore";
+        std::vector<std::vector<Document>> results;
+        for (const RelevanceModel model : {RelevanceModel::TF_IDF, RelevanceModel::BM25}) {
+            search_server.SetRelevanceModel(model);
+            LOG_DURATION((model == RelevanceModel::TF_IDF ? "TF-IDF, " : "BM25, ") + evaluation_name);
+            for (const std::string& query : queries) {
+                results.push_back(search_server.FindTopDocuments(query));
+            }
+        }
+        // Модели ранжируют по-разному: доля запросов с другим лучшим документом
+        std::size_t changed_count = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto& tf_idf = results[i];
+            const auto& bm25 = results[queries.size() + i];
+            changed_count += !tf_idf.empty() && !bm25.empty() && tf_idf.front().id != bm25.front().id;
+        }
+        std::cerr << "Queries with a different top document under BM25 (" << evaluation_name << "): "
+            << changed_count << " of " << queries.size() << std::endl;
+    }
+}
+
+namespace {
+
+// Возрастающий список номеров из [0, universe), каждый номер входит с вероятностью density:
+// промежутки между номерами имеют геометрическое распределение
+std::vector<DocumentOrdinal> GeneratePostingOrdinals(std::mt19937& generator, DocumentOrdinal universe, double density) {
+    std::geometric_distribution<DocumentOrdinal> gap_distribution(density);
+    std::vector<DocumentOrdinal> ordinals;
+    ordinals.reserve(static_cast<std::size_t>(universe * density * 1.1));
+    for (std::uint64_t ordinal = gap_distribution(generator); ordinal < universe;
+        ordinal += gap_distribution(generator) + 1) {
+        ordinals.push_back(static_cast<DocumentOrdinal>(ordinal));
+    }
+    return ordinals;
+}
+
+using IntersectFunction = std::size_t (*)(const DocumentOrdinal*, std::size_t,
+    const DocumentOrdinal*, std::size_t, DocumentOrdinal*);
+
+// Время пересечения всех пар списков и суммарная длина пересечений. Короткий список пары идет первым
+std::size_t RunIntersections(const std::string& name, IntersectFunction intersect,
+    const std::vector<std::vector<DocumentOrdinal>>& postings,
+    const std::vector<std::pair<std::size_t, std::size_t>>& pairs) {
+    std::vector<DocumentOrdinal> out;
+    std::size_t total_count = 0;
+    LOG_DURATION(name);
+    for (const auto& [lhs, rhs] : pairs) {
+        out.resize(postings[lhs].size());
+        total_count += intersect(postings[lhs].data(), postings[lhs].size(),
+            postings[rhs].data(), postings[rhs].size(), out.data());
+    }
+    return total_count;
+}
+
+} // namespace
+
+// Пересечение списков вхождений: слиянием, экспоненциальным поиском и блоками SSE2,
+// затем поиск документов со всеми словами против поиска документов с любым из слов
+void BenchmarkPostingIntersection() {
+    std::mt19937 generator;
+
+    // Частота i-го терма пропорциональна 1 / (i + 1), самый частый терм есть в трети документов
+    const DocumentOrdinal universe = 2'000'000;
+    std::vector<std::vector<DocumentOrdinal>> postings;
+    std::vector<double> weights;
+    for (int rank = 0; rank < 1'000; ++rank) {
+        postings.push_back(GeneratePostingOrdinals(generator, universe, 0.3 / (rank + 1)));
+        weights.push_back(1.0 / (rank + 1));
+    }
+
+    // Пары термов запросов с распределением Ципфа, разложенные по соотношению длин списков
+    std::discrete_distribution<std::size_t> rank_distribution(weights.begin(), weights.end());
+    const std::vector<std::pair<std::size_t, std::string>> ratio_groups = {
+        {4, "size ratio < 4"}, {GALLOPING_SIZE_RATIO, "size ratio in [4, 32)"}, {SIZE_MAX, "size ratio >= 32"}};
+    std::vector<std::vector<std::pair<std::size_t, std::size_t>>> group_pairs(ratio_groups.size());
+    for (int i = 0; i < 1'000; ++i) {
+        std::size_t lhs = rank_distribution(generator);
+        std::size_t rhs = rank_distribution(generator);
+        if (lhs == rhs) {
+            continue;
+        }
+        if (postings[lhs].size() > postings[rhs].size()) {
+            std::swap(lhs, rhs);
+        }
+        const std::size_t ratio = postings[rhs].size() / std::max<std::size_t>(postings[lhs].size(), 1);
+        const auto group = static_cast<std::size_t>(std::find_if(ratio_groups.begin(), ratio_groups.end(),
+            [ratio](const auto& ratio_group) { return ratio < ratio_group.first; }) - ratio_groups.begin());
+        group_pairs[group].push_back({lhs, rhs});
+    }
+
+    for (std::size_t group = 0; group < ratio_groups.size(); ++group) {
+        const std::string suffix = ", " + std::to_string(group_pairs[group].size()) + " pairs with "
+            + ratio_groups[group].second;
+        const std::size_t merge_count = RunIntersections("Scalar merge" + suffix, IntersectMerge,
+            postings, group_pairs[group]);
+        const std::size_t galloping_count = RunIntersections("Galloping" + suffix, IntersectGalloping,
+            postings, group_pairs[group]);
+        const std::size_t simd_count = RunIntersections("SIMD block compare" + suffix, IntersectSimd,
+            postings, group_pairs[group]);
+        const std::size_t adaptive_count = RunIntersections("Adaptive" + suffix, Intersect,
+            postings, group_pairs[group]);
+        BENCHMARK_CHECK(merge_count == galloping_count && merge_count == simd_count && merge_count == adaptive_count);
+    }
+
+    // Поиск: документы со всеми словами запроса против документов с любым из них
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateZipfQueries(generator, dictionary, 40'000, 30);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+    }
+    const auto queries = GenerateZipfQueries(generator, dictionary, 300, 3);
+    for (const QueryMatching matching : {QueryMatching::ANY_TERM, QueryMatching::ALL_TERMS}) {
+        search_server.SetQueryMatching(matching);
+        std::size_t found_count = 0;
+        {
+            LOG_DURATION(matching == QueryMatching::ANY_TERM ? "FindTopDocuments, 3-word ANY_TERM queries"
+                : "FindTopDocuments, 3-word ALL_TERMS queries");
+            for (const std::string& query : queries) {
+                found_count += search_server.FindTopDocuments(query).size();
+            }
+        }
+        std::cerr << "Documents found: " << found_count << std::endl;
+    }
+}
+
+// Поиск слов запросов в словаре термов: std::map против хэш-таблицы с открытой адресацией
+void BenchmarkTermLookup() {
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 50'000, 10);
+    std::map<std::string_view, TermId> map_term_ids;
+    TermHashMap hash_term_ids;
+    for (const std::string& word : dictionary) {
+        map_term_ids.emplace(word, static_cast<TermId>(map_term_ids.size()));
+        hash_term_ids.Emplace(word, static_cast<TermId>(hash_term_ids.size()));
+    }
+
+    // Слова запросов с распределением Ципфа, каждое пятое слово отсутствует в словаре
+    std::vector<std::string> words;
+    for (const std::string& query : GenerateZipfQueries(generator, dictionary, 100'000, 5)) {
+        for (const std::string_view word : SplitIntoWords(query)) {
+            words.emplace_back(word);
+            if (words.size() % 5 == 0) {
+                words.back().push_back('~');
+            }
+        }
+    }
+
+    std::uint64_t map_checksum = 0;
+    {
+        LOG_DURATION("Term lookup in std::map, " + std::to_string(words.size()) + " words");
+        for (const std::string& word : words) {
+            const auto it = map_term_ids.find(word);
+            map_checksum += it == map_term_ids.end() ? NO_TERM_ID : it->second;
+        }
+    }
+    std::uint64_t hash_checksum = 0;
+    {
+        LOG_DURATION("Term lookup in TermHashMap, " + std::to_string(words.size()) + " words");
+        for (const std::string& word : words) {
+            hash_checksum += hash_term_ids.Find(word);
+        }
+    }
+    BENCHMARK_CHECK(map_checksum == hash_checksum);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Генерация случайного слова длиной до max_length
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+// Генерация словаря из word_count уникальных слов
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+// Генерация запроса из word_count слов словаря, каждое слово с вероятностью minus_prob становится минус-словом
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int word_count, double minus_prob = 0);
+
+// Генерация набора запросов
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int max_word_count);
+
+// Генерация набора текстов из word_count слов, частота i-го слова словаря пропорциональна 1 / (i + 1)^exponent
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int word_count, double exponent = 1.0);
+
+// Сравнение последовательного и параллельного FindTopDocuments
+void BenchmarkParallelFindTopDocuments();
+
+
+// Сравнение пакетной обработки запросов с последовательными вызовами FindTopDocuments
+void BenchmarkProcessQueries();
+
+// Сравнение обхода и объема списков вхождений: map<string, map<int, double>> против PostingList
+void BenchmarkPostingLists();
+
+// Сравнение токенизатора на string_view с посимвольным копированием слов
+// и подсчет выделений памяти при разборе запроса
+void BenchmarkQueryParsing();
+
+// Поиск по запросам с большим числом минус-слов
+void BenchmarkMinusWords();
+
+// Сравнение холодного старта: индексация текстов против загрузки бинарного снимка
+void BenchmarkSnapshot();
+
+// Запросы к снимку, отображенному в память, против загруженного в кучу индекса
+void BenchmarkMappedSnapshot();
+
+// Параллельная индексация в шардированный сервер против последовательной в один SearchServer
+void BenchmarkShardedSearchServer();
+
+// Смешанная нагрузка чтения и записи: сервер под мьютексом против ConcurrentSearchServer
+void BenchmarkConcurrentSearchServer();
+
+// Пакетное добавление документов против поштучного AddDocument, в документах в секунду
+void BenchmarkAddDocuments();
+
+// Полный перебор против MaxScore на длинных запросах по словам с распределением Ципфа
+void BenchmarkMaxScore();
+
+// Поток повторяющихся запросов с распределением Ципфа: SearchServer против кэша выдачи
+void BenchmarkQueryResultCache();
+
+// Поиск с фильтром по каждому статусу и с предикатом по рейтингу
+void BenchmarkStatusFilters();
+
+// Предикаты-лямбды против предикатов из document_predicates.h, которые SearchServer сводит к маске
+void BenchmarkDocumentPredicates();
+
+// Фразы и NEAR/k против тех же слов без ограничений, объем позиций на одно вхождение
+void BenchmarkPhraseQueries();
+
+// Раскрытие префиксов по std::map и по словарю с фронтальным кодированием,
+// поиск по префиксам при разных пределах раскрытия
+void BenchmarkPrefixQueries();
+
+// TF-IDF против BM25 при полном переборе и MaxScore на документах разной длины
+void BenchmarkRelevanceModels();
+
+// Пересечение списков вхождений с распределением Ципфа: слияние, экспоненциальный поиск и блоки SSE2,
+// поиск документов со всеми словами запроса против поиска документов с любым из слов
+void BenchmarkPostingIntersection();
+
+// Поиск слов в словаре термов: std::map против хэш-таблицы с открытой адресацией
+void BenchmarkTermLookup();
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "compressed_postings.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Векторная распаковка собирается для x86 всегда, а вызывается, только если процессор поддерживает SSSE3.
+// Поэтому сборка без -mssse3 тоже распаковывает перестановкой байт
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define COMPRESSED_POSTINGS_SSSE3
+#endif
+
+namespace {
+
+// Длина числа в байтах по его двухбитному коду
+constexpr std::size_t GetCodeLength(std::uint8_t control, std::size_t index) {
+    return ((control >> (2 * index)) & 3) + 1;
+}
+
+// Суммарная длина четырех чисел по управляющему байту
+constexpr std::array<std::uint8_t, 256> MakeGroupLengths() {
+    std::array<std::uint8_t, 256> lengths{};
+    for (std::size_t control = 0; control < 256; ++control) {
+        std::size_t length = 0;
+        for (std::size_t index = 0; index < 4; ++index) {
+            length += GetCodeLength(static_cast<std::uint8_t>(control), index);
+        }
+        lengths[control] = static_cast<std::uint8_t>(length);
+    }
+    return lengths;
+}
+
+constexpr std::array<std::uint8_t, 256> GROUP_LENGTHS = MakeGroupLengths();
+
+#ifdef COMPRESSED_POSTINGS_SSSE3
+// Маска перестановки: байты каждого числа раскладываются в свои 32 бита, остальные обнуляются (0x80)
+constexpr std::array<std::array<std::uint8_t, 16>, 256> MakeShuffleMasks() {
+    std::array<std::array<std::uint8_t, 16>, 256> masks{};
+    for (std::size_t control = 0; control < 256; ++control) {
+        std::uint8_t source = 0;
+        for (std::size_t index = 0; index < 4; ++index) {
+            const std::size_t length = GetCodeLength(static_cast<std::uint8_t>(control), index);
+            for (std::size_t byte = 0; byte < 4; ++byte) {
+                masks[control][4 * index + byte] = byte < length ? source++ : 0x80;
+            }
+        }
+    }
+    return masks;
+}
+
+constexpr std::array<std::array<std::uint8_t, 16>, 256> SHUFFLE_MASKS = MakeShuffleMasks();
+#endif
+
+std::size_t GetValueLength(std::uint32_t value) {
+    return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+// Запись потока: сначала управляющие байты, затем байты чисел
+void EncodeStream(const std::uint32_t* values, std::size_t size, std::vector<std::uint8_t>& data) {
+    const std::size_t controls_begin = data.size();
+    data.resize(data.size() + (size + 3) / 4, 0);
+    for (std::size_t i = 0; i < size; ++i) {
+        const std::size_t length = GetValueLength(values[i]);
+        data[controls_begin + i / 4] |= static_cast<std::uint8_t>((length - 1) << (2 * (i % 4)));
+        for (std::size_t byte = 0; byte < length; ++byte) {
+            data.push_back(static_cast<std::uint8_t>(values[i] >> (8 * byte)));
+        }
+    }
+}
+
+// Длина байт чисел потока по его управляющим байтам
+std::size_t GetStreamDataLength(const std::uint8_t* controls, std::size_t size) {
+    std::size_t length = 0;
+    for (std::size_t group = 0; group < size / 4; ++group) {
+        length += GROUP_LENGTHS[controls[group]];
+    }
+    for (std::size_t i = size / 4 * 4; i < size; ++i) {
+        length += GetCodeLength(controls[i / 4], i % 4);
+    }
+    return length;
+}
+
+std::uint32_t DecodeValue(const std::uint8_t*& data, std::size_t length) {
+    std::uint32_t value = 0;
+    for (std::size_t byte = 0; byte < length; ++byte) {
+        value |= static_cast<std::uint32_t>(*data++) << (8 * byte);
+    }
+    return value;
+}
+
+#ifdef COMPRESSED_POSTINGS_SSSE3
+// Поддерживает ли процессор SSSE3. При сборке с -mssse3 проверка не нужна
+bool HasSsse3() {
+#ifdef __SSSE3__
+    return true;
+#else
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    return has_ssse3;
+#endif
+}
+
+// Распаковка одной четверки чисел перестановкой байт. Из bytes читается 16 байт.
+// carry - последняя префиксная сумма во всех четырех числах, нужна только при has_delta
+__attribute__((target("ssse3")))
+inline void DecodeGroupSsse3(std::uint8_t control, const std::uint8_t* bytes, bool has_delta, __m128i& carry,
+    std::uint32_t* values) {
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHUFFLE_MASKS[control].data()));
+    __m128i group = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)), mask);
+    if (has_delta) {
+        // Префиксная сумма четырех чисел за два сдвига и прибавление последней суммы прошлой четверки
+        group = _mm_add_epi32(group, _mm_slli_si128(group, 4));
+        group = _mm_add_epi32(group, _mm_slli_si128(group, 8));
+        group = _mm_add_epi32(group, carry);
+        carry = _mm_shuffle_epi32(group, 0xFF);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values), group);
+}
+
+// Распаковка всех полных четверок чисел потока. Пока до data_end есть 16 байт, они читаются
+// прямо из потока, остаток меньше 16 байт копируется в буфер с нулями. Возвращает колличество
+// распакованных чисел, data сдвигается за их байты
+__attribute__((target("ssse3")))
+std::size_t DecodeGroupsSsse3(const std::uint8_t* controls, const std::uint8_t*& data, const std::uint8_t* data_end,
+    std::size_t size, std::uint32_t* values, const std::uint32_t* delta_base) {
+    const bool has_delta = delta_base != nullptr;
+    __m128i carry = _mm_set1_epi32(has_delta ? static_cast<int>(*delta_base) : 0);
+    std::size_t i = 0;
+    for (; i + 4 <= size && data + 16 <= data_end; i += 4) {
+        const std::uint8_t control = controls[i / 4];
+        DecodeGroupSsse3(control, data, has_delta, carry, values + i);
+        data += GROUP_LENGTHS[control];
+    }
+    if (i + 4 > size) {
+        return i;
+    }
+    // Оставшиеся четверки занимают меньше 16 байт, а чтение из буфера заходит за них еще на 15 байт
+    std::uint8_t tail[32] = {};
+    std::memcpy(tail, data, static_cast<std::size_t>(data_end - data));
+    std::size_t offset = 0;
+    for (; i + 4 <= size; i += 4) {
+        const std::uint8_t control = controls[i / 4];
+        DecodeGroupSsse3(control, tail + offset, has_delta, carry, values + i);
+        offset += GROUP_LENGTHS[control];
+    }
+    data += offset;
+    return i;
+}
+#endif
+
+// Распаковка потока. Если delta_base задан, числа - разности, и на выходе их префиксные суммы.
+// data_end ограничивает чтение: векторная ветка читает по 16 байт и используется, пока они есть
+void DecodeStream(const std::uint8_t* controls, const std::uint8_t* data,
+    [[maybe_unused]] const std::uint8_t* data_end, std::size_t size, std::uint32_t* values, const std::uint32_t* delta_base) {
+    std::size_t i = 0;
+    std::uint32_t previous = delta_base != nullptr ? *delta_base : 0;
+
+#ifdef COMPRESSED_POSTINGS_SSSE3
+    if (HasSsse3()) {
+        i = DecodeGroupsSsse3(controls, data, data_end, size, values, delta_base);
+        if (delta_base != nullptr && i > 0) {
+            previous = values[i - 1];
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        const std::uint32_t value = DecodeValue(data, GetCodeLength(controls[i / 4], i % 4));
+        values[i] = delta_base != nullptr ? previous += value : value;
+    }
+}
+
+} // namespace
+
+double ComputeTermFreq(std::uint32_t term_count, std::uint32_t word_count) {
+    const double inv_word_count = 1.0 / word_count;
+    double term_freq = 0;
+    for (std::uint32_t i = 0; i < term_count; ++i) {
+        term_freq += inv_word_count;
+    }
+    return term_freq;
+}
+
+std::uint32_t ComputeTermCount(double term_freq, std::uint32_t word_count) {
+    const auto term_count = static_cast<std::uint32_t>(std::llround(term_freq * word_count));
+    if (term_count == 0 || ComputeTermFreq(term_count, word_count) != term_freq) {
+        throw std::invalid_argument("Term frequency is not a multiple of 1 / word count");
+    }
+    return term_count;
+}
+
+void EncodePostings(const DocumentOrdinal* document_ordinals, const std::uint32_t* term_counts, std::size_t size,
+    std::vector<PostingBlock>& blocks, std::vector<std::uint8_t>& data) {
+    std::uint32_t deltas[POSTING_BLOCK_SIZE];
+
+    for (std::size_t begin = 0; begin < size; begin += POSTING_BLOCK_SIZE) {
+        const std::size_t block_size = std::min(POSTING_BLOCK_SIZE, size - begin);
+        const DocumentOrdinal* ordinals = document_ordinals + begin;
+
+        PostingBlock block;
+        block.offset = data.size();
+        block.size = static_cast<std::uint32_t>(block_size);
+        block.first_ordinal = ordinals[0];
+        block.last_ordinal = ordinals[block_size - 1];
+
+        // Первая разность отсчитывается от первого номера блока, поэтому равна нулю
+        deltas[0] = 0;
+        for (std::size_t i = 1; i < block_size; ++i) {
+            deltas[i] = ordinals[i] - ordinals[i - 1];
+        }
+        EncodeStream(deltas, block_size, data);
+        EncodeStream(term_counts + begin, block_size, data);
+
+        block.byte_size = static_cast<std::uint32_t>(data.size() - block.offset);
+        blocks.push_back(block);
+    }
+}
+
+std::size_t DecodePostingBlock(const PostingBlock& block, const std::uint8_t* data,
+    DocumentOrdinal* document_ordinals, std::uint32_t* term_counts) {
+    const std::size_t size = block.size;
+    const std::size_t control_length = (size + 3) / 4;
+    const std::uint8_t* begin = data + block.offset;
+    const std::uint8_t* end = begin + block.byte_size;
+
+    const std::uint8_t* ordinal_controls = begin;
+    const std::uint8_t* ordinal_data = ordinal_controls + control_length;
+    if (size == 0 || size > POSTING_BLOCK_SIZE || 2 * control_length > block.byte_size) {
+        throw std::runtime_error("Compressed posting block is corrupted");
+    }
+    const std::size_t ordinal_data_length = GetStreamDataLength(ordinal_controls, size);
+    if (2 * control_length + ordinal_data_length > block.byte_size) {
+        throw std::runtime_error("Compressed posting block is corrupted");
+    }
+    const std::uint8_t* count_controls = ordinal_data + ordinal_data_length;
+    const std::uint8_t* count_data = count_controls + control_length;
+    if (count_data + GetStreamDataLength(count_controls, size) != end) {
+        throw std::runtime_error("Compressed posting block is corrupted");
+    }
+
+    DecodeStream(ordinal_controls, ordinal_data, count_controls, size, document_ordinals, &block.first_ordinal);
+    DecodeStream(count_controls, count_data, end, size, term_counts, nullptr);
+    return size;
+}
+
+CompressedPostings::CompressedPostings(const PostingBlock* blocks, std::size_t block_count, const std::uint8_t* data)
+    : blocks_(blocks)
+    , block_count_(block_count)
+    , data_(data) {
+}
+
+std::size_t CompressedPostings::size() const {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < block_count_; ++i) {
+        size += blocks_[i].size;
+    }
+    return size;
+}
+
+std::optional<std::uint32_t> CompressedPostings::FindTermCount(DocumentOrdinal ordinal) const {
+    const PostingBlock* block = FindBlock(ordinal);
+    if (block == blocks_ + block_count_ || block->first_ordinal > ordinal) {
+        return std::nullopt;
+    }
+    alignas(16) DocumentOrdinal document_ordinals[POSTING_BLOCK_SIZE];
+    alignas(16) std::uint32_t term_counts[POSTING_BLOCK_SIZE];
+    const std::size_t size = DecodePostingBlock(*block, data_, document_ordinals, term_counts);
+
+    const DocumentOrdinal* it = std::lower_bound(document_ordinals, document_ordinals + size, ordinal);
+    if (it == document_ordinals + size || *it != ordinal) {
+        return std::nullopt;
+    }
+    return term_counts[it - document_ordinals];
+}
+
+const PostingBlock* CompressedPostings::FindBlock(DocumentOrdinal ordinal) const {
+    return std::lower_bound(blocks_, blocks_ + block_count_, ordinal,
+        [](const PostingBlock& block, DocumentOrdinal value) { return block.last_ordinal < value; });
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "posting_list.h"
+
+// Сжатые списки вхождений. Список делится на блоки по POSTING_BLOCK_SIZE вхождений,
+// в блоке хранятся разности соседних номеров документов и колличества вхождений слова,
+// каждое число - от 1 до 4 байт с двухбитным кодом длины (схема StreamVByte).
+// Четыре кода длины занимают один управляющий байт, поэтому четверка чисел распаковывается
+// одной перестановкой байт SSSE3. Поддержка SSSE3 проверяется во время работы, поэтому перестановка
+// используется и без -mssse3, а скалярная распаковка остается для процессоров без SSSE3
+constexpr std::size_t POSTING_BLOCK_SIZE = 128;
+
+// Указатель пропуска: границы номеров блока и его место в массиве байт
+struct PostingBlock {
+    // Смещение блока от начала массива байт
+    std::uint64_t offset;
+    std::uint32_t byte_size;
+    std::uint32_t size;
+    DocumentOrdinal first_ordinal;
+    DocumentOrdinal last_ordinal;
+};
+
+// Частота слова вычисляется так же, как ее накапливает AddDocument: term_count раз
+// прибавляется 1 / word_count, поэтому значение совпадает побитово
+double ComputeTermFreq(std::uint32_t term_count, std::uint32_t word_count);
+
+// Колличество вхождений слова по частоте, обратное ComputeTermFreq
+std::uint32_t ComputeTermCount(double term_freq, std::uint32_t word_count);
+
+// Сжатие списка: блоки дописываются в blocks, их байты - в data
+void EncodePostings(const DocumentOrdinal* document_ordinals, const std::uint32_t* term_counts, std::size_t size,
+    std::vector<PostingBlock>& blocks, std::vector<std::uint8_t>& data);
+
+// Распаковка блока в буферы размером не меньше POSTING_BLOCK_SIZE, возвращает колличество вхождений.
+// Бросает std::runtime_error, если коды длин не сходятся с размером блока
+std::size_t DecodePostingBlock(const PostingBlock& block, const std::uint8_t* data,
+    DocumentOrdinal* document_ordinals, std::uint32_t* term_counts);
+
+// Сжатый список вхождений поверх чужой памяти, например отображенного файла
+class CompressedPostings {
+    public:
+        CompressedPostings(const PostingBlock* blocks, std::size_t block_count, const std::uint8_t* data);
+
+        std::size_t size() const;
+
+        // Обход вхождений с номерами из [lower, upper): callback(номер документа, колличество вхождений).
+        // Блоки до lower пропускаются по указателям без распаковки
+        template <typename Callback>
+        void ForEach(DocumentOrdinal lower, DocumentOrdinal upper, Callback callback) const;
+
+        // Колличество вхождений слова в документ, распаковывается только блок с этим номером
+        std::optional<std::uint32_t> FindTermCount(DocumentOrdinal ordinal) const;
+
+    private:
+        const PostingBlock* blocks_;
+        std::size_t block_count_;
+        const std::uint8_t* data_;
+
+        // Первый блок, последний номер которого не меньше ordinal
+        const PostingBlock* FindBlock(DocumentOrdinal ordinal) const;
+};
+
+// Реализация шаблонных функций
+
+template <typename Callback>
+void CompressedPostings::ForEach(DocumentOrdinal lower, DocumentOrdinal upper, Callback callback) const {
+    alignas(16) DocumentOrdinal document_ordinals[POSTING_BLOCK_SIZE];
+    alignas(16) std::uint32_t term_counts[POSTING_BLOCK_SIZE];
+
+    for (const PostingBlock* block = FindBlock(lower); block != blocks_ + block_count_
+        && block->first_ordinal < upper; ++block) {
+        const std::size_t size = DecodePostingBlock(*block, data_, document_ordinals, term_counts);
+        // Границы проверяются только у блоков, которые выходят за [lower, upper)
+        if (block->first_ordinal >= lower && block->last_ordinal < upper) {
+            for (std::size_t i = 0; i < size; ++i) {
+                callback(document_ordinals[i], term_counts[i]);
+            }
+            continue;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            if (document_ordinals[i] >= lower && document_ordinals[i] < upper) {
+                callback(document_ordinals[i], term_counts[i]);
+            }
+        }
+    }
+}
\ No newline at end of file
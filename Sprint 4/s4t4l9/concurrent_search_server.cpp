@@ -0,0 +1,377 @@
+#include "concurrent_search_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "string_processing.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words_text, std::size_t buffer_capacity,
+    std::size_t max_segment_count)
+    : stop_words_(MakeUniqueNonEmptyStrings(SplitIntoWords(stop_words_text)))
+    , buffer_capacity_(buffer_capacity)
+    , max_segment_count_(std::max<std::size_t>(max_segment_count, 1))
+    , version_(std::make_shared<const IndexVersion>()) {
+
+    if (std::any_of(stop_words_.begin(), stop_words_.end(), [](std::string_view word){return !IsValidWord(word);})) {
+        throw std::invalid_argument("Stop words have special symbols!");
+    }
+    merge_thread_ = std::thread([this] { RunMerges(); });
+}
+
+ConcurrentSearchServer::~ConcurrentSearchServer() {
+    {
+        const std::lock_guard lock(write_mutex_);
+        is_stopping_ = true;
+    }
+    merge_condition_.notify_all();
+    merge_thread_.join();
+}
+
+// Новый документ дописывается в буфер записи
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    const std::lock_guard lock(write_mutex_);
+    IndexVersion version = *LoadVersion();
+
+    if (HasDocument(version, document_id)) {
+        throw std::invalid_argument("Document ID is wrong or a document with this ID has already been added earlier");
+    }
+
+    // Удаленный документ с тем же ID выбрасывается из своего сегмента сразу, чтобы ID в индексе не повторялись.
+    // Вместе с ним выбрасываются остальные удаленные документы сегмента
+    if (version.removed_document_ids->count(document_id) > 0) {
+        for (std::size_t i = 0; i < version.segments.size(); ++i) {
+            const SearchServer& segment = *version.segments[i];
+            if (!segment.HasDocument(document_id)) {
+                continue;
+            }
+            auto removed_document_ids = std::make_shared<std::set<int>>();
+            for (const int removed_document_id : *version.removed_document_ids) {
+                if (!segment.HasDocument(removed_document_id)) {
+                    removed_document_ids->insert(removed_document_id);
+                }
+            }
+            auto rewritten = std::make_shared<const SearchServer>(
+                SearchServer::Merge({&segment}, *version.removed_document_ids));
+            if (rewritten->GetDocumentCount() == 0) {
+                version.segments.erase(version.segments.begin() + static_cast<std::ptrdiff_t>(i));
+                version.removed_ordinals.erase(version.removed_ordinals.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                version.segments[i] = std::move(rewritten);
+                version.removed_ordinals[i] = nullptr;
+            }
+            version.removed_document_ids = std::move(removed_document_ids);
+            break;
+        }
+    }
+
+    WriteBuffer(version, [document_id, document = std::string(document), status, ratings](SearchServer& buffer) {
+        buffer.AddDocument(document_id, document, status, ratings);
+    });
+    PublishVersion(std::move(version));
+}
+
+// Документ из буфера удаляется из него сразу, документ сброшенного сегмента помечается
+// удаленным и выбрасывается фоновым слиянием
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    const std::lock_guard lock(write_mutex_);
+    IndexVersion version = *LoadVersion();
+    if (!HasDocument(version, document_id)) {
+        return;
+    }
+
+    if (version.write_buffer != nullptr && version.write_buffer->HasDocument(document_id)) {
+        WriteBuffer(version, [document_id](SearchServer& buffer) {
+            buffer.RemoveDocument(document_id);
+        });
+        PublishVersion(std::move(version));
+        return;
+    }
+
+    for (std::size_t i = 0; i < version.segments.size(); ++i) {
+        if (version.segments[i]->HasDocument(document_id)) {
+            auto removed_document_ids = std::make_shared<std::set<int>>(*version.removed_document_ids);
+            removed_document_ids->insert(document_id);
+            version.removed_ordinals[i] = std::make_shared<const DocumentBitset>(
+                version.segments[i]->GetDocumentOrdinals(*removed_document_ids));
+            version.removed_document_ids = std::move(removed_document_ids);
+            break;
+        }
+    }
+    PublishVersion(std::move(version));
+    merge_condition_.notify_all();
+}
+
+void ConcurrentSearchServer::Flush() {
+    std::unique_lock lock(write_mutex_);
+    IndexVersion version = *LoadVersion();
+    SealWriteBuffer(version);
+    PublishVersion(std::move(version));
+    merge_condition_.notify_all();
+
+    merge_condition_.wait(lock, [this] {
+        return !is_merging_ && (merge_error_ != nullptr || !NeedsMerge(*LoadVersion()));
+    });
+    if (merge_error_ != nullptr) {
+        std::rethrow_exception(std::exchange(merge_error_, nullptr));
+    }
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    std::size_t max_count) const {
+    return FindTopDocuments(raw_query, ByStatus{status}, max_count);
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    const std::shared_ptr<const IndexVersion> version = LoadVersion();
+    int document_count = 0;
+    for (const SearchServer* search_server : GetSearchServers(*version)) {
+        document_count += search_server->GetDocumentCount();
+    }
+    return document_count - static_cast<int>(version->removed_document_ids->size());
+}
+
+std::size_t ConcurrentSearchServer::GetSegmentCount() const {
+    const std::shared_ptr<const IndexVersion> version = LoadVersion();
+    return version->segments.size() + (version->write_buffer != nullptr ? 1 : 0);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ConcurrentSearchServer::MatchDocument(
+    std::string_view raw_query, int document_id) const {
+    const std::shared_ptr<const IndexVersion> version = LoadVersion();
+    if (version->removed_document_ids->count(document_id) == 0) {
+        for (const SearchServer* search_server : GetSearchServers(*version)) {
+            if (search_server->HasDocument(document_id)) {
+                const auto [words, status] = search_server->MatchDocument(raw_query, document_id);
+                return {std::vector<std::string>(words.begin(), words.end()), status};
+            }
+        }
+    }
+    throw std::out_of_range("Document with this ID does not exist");
+}
+
+std::shared_ptr<const ConcurrentSearchServer::IndexVersion> ConcurrentSearchServer::LoadVersion() const {
+    return std::atomic_load(&version_);
+}
+
+void ConcurrentSearchServer::PublishVersion(IndexVersion version) {
+    ++publish_count_;
+    std::atomic_store(&version_, std::shared_ptr<const IndexVersion>(
+        std::make_shared<const IndexVersion>(std::move(version))));
+}
+
+std::vector<const SearchServer*> ConcurrentSearchServer::GetSearchServers(const IndexVersion& version) {
+    std::vector<const SearchServer*> search_servers;
+    search_servers.reserve(version.segments.size() + 1);
+    for (const auto& segment : version.segments) {
+        search_servers.push_back(segment.get());
+    }
+    if (version.write_buffer != nullptr) {
+        search_servers.push_back(version.write_buffer.get());
+    }
+    return search_servers;
+}
+
+bool ConcurrentSearchServer::HasDocument(const IndexVersion& version, int document_id) {
+    if (version.removed_document_ids->count(document_id) > 0) {
+        return false;
+    }
+    const std::vector<const SearchServer*> search_servers = GetSearchServers(version);
+    return std::any_of(search_servers.begin(), search_servers.end(), [document_id](const SearchServer* search_server) {
+        return search_server->HasDocument(document_id);
+    });
+}
+
+void ConcurrentSearchServer::ResetWriteBuffer() {
+    buffer_replicas_.clear();
+    buffer_writes_.clear();
+}
+
+void ConcurrentSearchServer::WriteBuffer(IndexVersion& version, BufferWrite write) {
+    // Копию без других владельцев не держит ни одна версия, в том числе опубликованная.
+    // Из таких берется самая свежая, чтобы повторять меньше изменений
+    std::size_t replica_index = buffer_replicas_.size();
+    for (std::size_t i = 0; i < buffer_replicas_.size(); ++i) {
+        if (buffer_replicas_[i].search_server.use_count() == 1 && (replica_index == buffer_replicas_.size()
+                || buffer_replicas_[i].applied_write_count > buffer_replicas_[replica_index].applied_write_count)) {
+            replica_index = i;
+        }
+    }
+    if (replica_index == buffer_replicas_.size()) {
+        buffer_replicas_.push_back({std::make_shared<SearchServer>(stop_words_), 0});
+    }
+    BufferReplica& replica = buffer_replicas_[replica_index];
+    // Последний читатель отпускает копию уменьшением счетчика с release, барьер упорядочивает
+    // его чтения копии перед изменениями писателя
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Изменения из журнала уже однажды прошли успешно, поэтому повторяются без исключений
+    for (; replica.applied_write_count < buffer_writes_.size(); ++replica.applied_write_count) {
+        buffer_writes_[replica.applied_write_count](*replica.search_server);
+    }
+    buffer_writes_.push_back(std::move(write));
+    try {
+        buffer_writes_.back()(*replica.search_server);
+    } catch (...) {
+        buffer_writes_.pop_back();
+        throw;
+    }
+    ++replica.applied_write_count;
+
+    if (static_cast<std::size_t>(replica.search_server->GetDocumentCount()) >= buffer_capacity_) {
+        version.write_buffer = replica.search_server;
+        SealWriteBuffer(version);
+        return;
+    }
+    version.write_buffer = replica.search_server->GetDocumentCount() > 0 ? replica.search_server : nullptr;
+}
+
+// Буфер становится сброшенным сегментом, поэтому писатель больше не меняет его копии и начинает новые
+void ConcurrentSearchServer::SealWriteBuffer(IndexVersion& version) {
+    if (version.write_buffer != nullptr) {
+        version.segments.push_back(std::move(version.write_buffer));
+        version.removed_ordinals.push_back(nullptr);
+        version.write_buffer = nullptr;
+    }
+    ResetWriteBuffer();
+    merge_condition_.notify_all();
+}
+
+bool ConcurrentSearchServer::NeedsMerge(const IndexVersion& version) const {
+    return version.segments.size() > max_segment_count_ || !version.removed_document_ids->empty();
+}
+
+// Слияние идет без блокировки: писатели за это время могут опубликовать новые версии.
+// Результат публикуется, только если все слитые сегменты еще лежат в текущей версии.
+// Неудачное слияние оставляет опубликованной прежнюю версию и повторяется после следующей публикации
+void ConcurrentSearchServer::RunMerges() {
+    std::unique_lock lock(write_mutex_);
+    std::uint64_t failed_publish_count = std::numeric_limits<std::uint64_t>::max();
+    while (true) {
+        merge_condition_.wait(lock, [this, &failed_publish_count] {
+            return is_stopping_ || (NeedsMerge(*LoadVersion()) && publish_count_ != failed_publish_count);
+        });
+        if (is_stopping_) {
+            return;
+        }
+
+        // На время слияния версия не удерживается целиком: иначе писатель ждал бы, пока слияние
+        // отпустит копию буфера записи из этой версии
+        const std::uint64_t merge_publish_count = publish_count_;
+        Segments inputs;
+        std::shared_ptr<const std::set<int>> removed_document_ids;
+        {
+            const std::shared_ptr<const IndexVersion> version = LoadVersion();
+            const std::vector<std::size_t> selected = SelectSegmentsToMerge(*version);
+            // Удаленные ID, которых нет ни в одном сегменте, сливать не с чем: они просто забываются
+            if (selected.empty()) {
+                IndexVersion next_version = *version;
+                next_version.removed_document_ids = std::make_shared<const std::set<int>>();
+                PublishVersion(std::move(next_version));
+                merge_condition_.notify_all();
+                continue;
+            }
+            for (const std::size_t index : selected) {
+                inputs.push_back(version->segments[index]);
+            }
+            removed_document_ids = version->removed_document_ids;
+        }
+
+        try {
+            is_merging_ = true;
+            lock.unlock();
+            std::vector<const SearchServer*> input_servers;
+            for (const auto& input : inputs) {
+                input_servers.push_back(input.get());
+            }
+            auto merged = std::make_shared<const SearchServer>(SearchServer::Merge(input_servers,
+                *removed_document_ids));
+            lock.lock();
+            is_merging_ = false;
+
+            IndexVersion next_version = *LoadVersion();
+            const auto first_input = std::find(next_version.segments.begin(), next_version.segments.end(),
+                inputs.front());
+            const bool are_inputs_current = first_input != next_version.segments.end()
+                && static_cast<std::size_t>(next_version.segments.end() - first_input) >= inputs.size()
+                && std::equal(inputs.begin(), inputs.end(), first_input);
+
+            if (are_inputs_current) {
+                // Слияние выбросило удаленные документы своих сегментов. Документы, удаленные
+                // во время слияния, остаются помеченными уже в слитом сегменте
+                auto next_removed_document_ids = std::make_shared<std::set<int>>();
+                for (const int document_id : *next_version.removed_document_ids) {
+                    const bool is_merged_away = removed_document_ids->count(document_id) > 0
+                        && std::any_of(inputs.begin(), inputs.end(), [document_id](const auto& input) {
+                            return input->HasDocument(document_id);
+                        });
+                    if (!is_merged_away) {
+                        next_removed_document_ids->insert(document_id);
+                    }
+                }
+                std::shared_ptr<const DocumentBitset> merged_removed_ordinals;
+                if (std::any_of(next_removed_document_ids->begin(), next_removed_document_ids->end(),
+                        [&merged](int document_id) { return merged->HasDocument(document_id); })) {
+                    merged_removed_ordinals = std::make_shared<const DocumentBitset>(
+                        merged->GetDocumentOrdinals(*next_removed_document_ids));
+                }
+
+                const auto first_index = first_input - next_version.segments.begin();
+                const auto input_count = static_cast<std::ptrdiff_t>(inputs.size());
+                next_version.segments.erase(next_version.segments.begin() + first_index + 1,
+                    next_version.segments.begin() + first_index + input_count);
+                next_version.removed_ordinals.erase(next_version.removed_ordinals.begin() + first_index + 1,
+                    next_version.removed_ordinals.begin() + first_index + input_count);
+                if (merged->GetDocumentCount() == 0) {
+                    next_version.segments.erase(next_version.segments.begin() + first_index);
+                    next_version.removed_ordinals.erase(next_version.removed_ordinals.begin() + first_index);
+                } else {
+                    next_version.segments[static_cast<std::size_t>(first_index)] = std::move(merged);
+                    next_version.removed_ordinals[static_cast<std::size_t>(first_index)]
+                        = std::move(merged_removed_ordinals);
+                }
+                next_version.removed_document_ids = std::move(next_removed_document_ids);
+                PublishVersion(std::move(next_version));
+            }
+            failed_publish_count = std::numeric_limits<std::uint64_t>::max();
+        } catch (...) {
+            if (!lock.owns_lock()) {
+                lock.lock();
+            }
+            is_merging_ = false;
+            merge_error_ = std::current_exception();
+            failed_publish_count = merge_publish_count;
+        }
+        merge_condition_.notify_all();
+    }
+}
+
+std::vector<std::size_t> ConcurrentSearchServer::SelectSegmentsToMerge(const IndexVersion& version) const {
+    const Segments& segments = version.segments;
+    if (segments.size() > max_segment_count_) {
+        std::size_t best = 0;
+        int best_document_count = std::numeric_limits<int>::max();
+        for (std::size_t i = 0; i + 1 < segments.size(); ++i) {
+            const int document_count = segments[i]->GetDocumentCount() + segments[i + 1]->GetDocumentCount();
+            if (document_count < best_document_count) {
+                best = i;
+                best_document_count = document_count;
+            }
+        }
+        return {best, best + 1};
+    }
+    // Удаленные документы есть ровно у тех сегментов, у которых есть набор их номеров
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if (version.removed_ordinals[i] != nullptr) {
+            return {i};
+        }
+    }
+    return {};
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "document_bitset.h"
+#include "query.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Поисковый сервер, в который можно добавлять документы во время запросов. Индекс устроен
+// как LSM-дерево из неизменяемых сегментов (SearchServer):
+// - новые документы дописываются в буфер записи - один изменяемый сегмент;
+// - заполненный буфер становится обычным сегментом, а фоновый поток сливает сегменты,
+//   пока их не станет не больше max_segment_count;
+// - удаленные документы сброшенных сегментов помечаются и выбрасываются при слиянии.
+// Писатель собирает новую версию индекса и публикует ее атомарной заменой указателя,
+// а читатель работает с той версией, которую взял в начале запроса, и не ждет ни писателя,
+// ни слияния. Старые сегменты освобождаются, когда их отпускает последний читатель.
+// Буфер записи хранится в нескольких копиях: опубликованную читают, а писатель берет копию,
+// которую не держит ни одна версия, догоняет ее по журналу изменений буфера, дописывает новое
+// изменение и публикует ее. Писатель не ждет читателей: если свободной копии нет, заводится новая.
+// Обычно копий две, и запись стоит два добавления в небольшой сегмент, а не копию буфера
+class ConcurrentSearchServer {
+    
+    public:
+        explicit ConcurrentSearchServer(std::string_view stop_words_text, std::size_t buffer_capacity = 1024,
+            std::size_t max_segment_count = 4);
+
+        ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+
+        ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+
+        ~ConcurrentSearchServer();
+
+        // Писатели выполняются по очереди, читателей не блокируют
+        void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+            const std::vector<int>& ratings);
+
+        void RemoveDocument(int document_id);
+
+        // Сброс буфера записи и ожидание, пока фоновый поток закончит слияния и применит удаления.
+        // Если слияние завершилось исключением, оно пробрасывается отсюда, а индекс остается прежним
+        void Flush();
+
+        template <typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+            std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+        int GetDocumentCount() const;
+
+        // Колличество сегментов, включая непустой буфер записи
+        std::size_t GetSegmentCount() const;
+
+        // Найденные слова ссылаются на сегмент, который может быть заменен писателем,
+        // поэтому здесь они копируются
+        std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query,
+            int document_id) const;
+
+    private:
+        using Segments = std::vector<std::shared_ptr<const SearchServer>>;
+
+        // Опубликованная версия индекса, после публикации не меняется. Версии делят между собой
+        // сегменты и наборы удаленных документов, поэтому публикация не копирует индекс
+        struct IndexVersion {
+            Segments segments;
+            // Номера удаленных документов каждого сброшенного сегмента, индексы совпадают с segments.
+            // nullptr - в сегменте нет удаленных документов. Набор сегмента строится заново,
+            // только когда в этом сегменте удаляют документ
+            std::vector<std::shared_ptr<const DocumentBitset>> removed_ordinals;
+            // Опубликованная копия буфера записи, nullptr - буфер пуст
+            std::shared_ptr<const SearchServer> write_buffer;
+            // Удаленные документы сброшенных сегментов, еще не выброшенные слиянием.
+            // Каждый такой ID лежит ровно в одном сброшенном сегменте
+            std::shared_ptr<const std::set<int>> removed_document_ids = std::make_shared<const std::set<int>>();
+        };
+
+        // Изменение буфера записи, которое нужно повторить в каждой его копии
+        using BufferWrite = std::function<void(SearchServer&)>;
+
+        struct BufferReplica {
+            std::shared_ptr<SearchServer> search_server;
+            // Сколько изменений из журнала buffer_writes_ уже применено к копии
+            std::size_t applied_write_count = 0;
+        };
+
+        const std::set<std::string, std::less<>> stop_words_;
+        const std::size_t buffer_capacity_;
+        const std::size_t max_segment_count_;
+
+        // Читается и заменяется через std::atomic_load / std::atomic_store
+        std::shared_ptr<const IndexVersion> version_;
+
+        // Защищает публикацию версий и копии буфера от одновременных писателей и фонового слияния
+        std::mutex write_mutex_;
+        // Копии буфера записи и журнал его изменений с последнего сброса
+        std::vector<BufferReplica> buffer_replicas_;
+        std::vector<BufferWrite> buffer_writes_;
+        // Колличество публикаций, по нему фоновый поток узнает, что версия сменилась после неудачного слияния
+        std::uint64_t publish_count_ = 0;
+        std::condition_variable merge_condition_;
+        bool is_merging_ = false;
+        bool is_stopping_ = false;
+        // Исключение последнего неудачного слияния, еще не переданное в Flush
+        std::exception_ptr merge_error_;
+        std::thread merge_thread_;
+
+        std::shared_ptr<const IndexVersion> LoadVersion() const;
+
+        void PublishVersion(IndexVersion version);
+
+        // Все сегменты версии: сброшенные и буфер записи
+        static std::vector<const SearchServer*> GetSearchServers(const IndexVersion& version);
+
+        static bool HasDocument(const IndexVersion& version, int document_id);
+
+        // Пустой буфер записи: копии и журнал сбрасываются
+        void ResetWriteBuffer();
+
+        // Изменение буфера: свободная копия догоняет журнал, получает write и публикуется.
+        // Заполненный буфер сразу становится сброшенным сегментом. Если write бросает исключение,
+        // буфер и версия остаются прежними. Вызывается под write_mutex_
+        void WriteBuffer(IndexVersion& version, BufferWrite write);
+
+        // Перенос буфера записи в сброшенные сегменты, вызывается под write_mutex_
+        void SealWriteBuffer(IndexVersion& version);
+
+        bool NeedsMerge(const IndexVersion& version) const;
+
+        // Фоновый поток: выбирает сегменты, сливает их без блокировки и публикует результат
+        void RunMerges();
+
+        // Номера сегментов для очередного слияния: два соседних сегмента с наименьшим числом документов,
+        // если сегментов слишком много, иначе сегмент с удаленными документами
+        std::vector<std::size_t> SelectSegmentsToMerge(const IndexVersion& version) const;
+};
+
+// Реализация шаблонных функций
+
+// IDF считается по всем сегментам без удаленных документов, поэтому выдача совпадает
+// с выдачей одного SearchServer. Документы разных сегментов не пересекаются, поэтому топ,
+// собранный по сегментам, равен топу по k-путевому слиянию их списков вхождений
+template <typename DocumentPredicate>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, stop_words_, &query_buffer.resource);
+
+    const std::shared_ptr<const IndexVersion> version = LoadVersion();
+    const std::vector<const SearchServer*> search_servers = GetSearchServers(*version);
+    const std::vector<double> inverse_document_freqs = SearchServer::ComputeInverseDocumentFreqs(search_servers, query,
+        *version->removed_document_ids);
+
+    // Удаленные документы отсекаются по номерам, а не поиском ID в наборе на каждый документ.
+    // Буфер записи идет после сброшенных сегментов и удаленных документов не содержит
+    TopDocuments top_documents(max_count);
+    for (std::size_t i = 0; i < search_servers.size(); ++i) {
+        const DocumentBitset* removed_ordinals = i < version->removed_ordinals.size()
+            ? version->removed_ordinals[i].get() : nullptr;
+        search_servers[i]->CollectTopDocuments(std::execution::seq, query, inverse_document_freqs,
+            document_predicate, top_documents, removed_ordinals);
+    }
+    return top_documents.Extract();
+}
\ No newline at end of file
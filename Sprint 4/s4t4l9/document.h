@@ -1,6 +1,8 @@
 #pragma once
 
 #include <ostream>
+#include <string_view>
+#include <vector>
 
 struct Document {
     Document();
@@ -19,6 +21,14 @@ enum class DocumentStatus {
     REMOVED,
 };
 
+// Документ для пакетного добавления, текст должен жить до конца вызова AddDocuments
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 // Вывод документа на печать
 std::ostream& operator<<(std::ostream& out, const Document& document);
 
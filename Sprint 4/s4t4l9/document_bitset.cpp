@@ -0,0 +1,56 @@
+#include "document_bitset.h"
+
+#include <algorithm>
+
+DocumentBitset::DocumentBitset(std::size_t size) {
+    Resize(size);
+}
+
+void DocumentBitset::Resize(std::size_t size) {
+    // Хвост последнего слова мог содержать установленные биты за старой границей
+    if (size > size_ && size_ % WORD_BITS != 0) {
+        words_[size_ / WORD_BITS] &= (std::uint64_t{1} << (size_ % WORD_BITS)) - 1;
+    }
+    words_.resize((size + WORD_BITS - 1) / WORD_BITS, 0);
+    size_ = size;
+}
+
+void DocumentBitset::Clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+void DocumentBitset::Set(std::size_t index) {
+    words_[index / WORD_BITS] |= std::uint64_t{1} << (index % WORD_BITS);
+}
+
+void DocumentBitset::Reset(std::size_t index) {
+    words_[index / WORD_BITS] &= ~(std::uint64_t{1} << (index % WORD_BITS));
+}
+
+bool DocumentBitset::Test(std::size_t index) const {
+    return (words_[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+std::size_t DocumentBitset::FindNthReset(std::size_t n) const {
+    for (std::size_t word = 0; word < words_.size(); ++word) {
+        std::uint64_t reset_bits = ~words_[word];
+        // Биты за границей набора в последнем слове не считаются
+        if ((word + 1) * WORD_BITS > size_) {
+            reset_bits &= (std::uint64_t{1} << (size_ % WORD_BITS)) - 1;
+        }
+        const auto count = static_cast<std::size_t>(__builtin_popcountll(reset_bits));
+        if (n >= count) {
+            n -= count;
+            continue;
+        }
+        for (; n > 0; --n) {
+            reset_bits &= reset_bits - 1;
+        }
+        return word * WORD_BITS + static_cast<std::size_t>(__builtin_ctzll(reset_bits));
+    }
+    return size_;
+}
+
+std::size_t DocumentBitset::size() const {
+    return size_;
+}
\ No newline at end of file
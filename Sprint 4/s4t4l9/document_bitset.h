@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Битовый набор документов, индекс - номер документа относительно начала диапазона
+class DocumentBitset {
+    public:
+        DocumentBitset() = default;
+
+        explicit DocumentBitset(std::size_t size);
+
+        // Изменение размера, новые биты сброшены
+        void Resize(std::size_t size);
+
+        // Сброс всех битов
+        void Clear();
+
+        void Set(std::size_t index);
+
+        void Reset(std::size_t index);
+
+        bool Test(std::size_t index) const;
+
+        // Индекс n-го (считая с нуля) сброшенного бита или size(), если сброшенных битов не больше n.
+        // Слова пропускаются по колличеству сброшенных битов, поэтому поиск стоит O(size / 64)
+        std::size_t FindNthReset(std::size_t n) const;
+
+        std::size_t size() const;
+
+    private:
+        static constexpr std::size_t WORD_BITS = 64;
+
+        std::vector<std::uint64_t> words_;
+        std::size_t size_ = 0;
+};
\ No newline at end of file
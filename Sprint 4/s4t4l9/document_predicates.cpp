@@ -0,0 +1,25 @@
+#include "document_predicates.h"
+
+#include <algorithm>
+
+bool ByStatus::operator()(int, DocumentStatus document_status, int rating) const {
+    return MatchesColumns(document_status, rating);
+}
+
+bool RatingRange::operator()(int, DocumentStatus status, int rating) const {
+    return MatchesColumns(status, rating);
+}
+
+IdSet::IdSet(std::vector<int> document_ids) {
+    std::sort(document_ids.begin(), document_ids.end());
+    document_ids.erase(std::unique(document_ids.begin(), document_ids.end()), document_ids.end());
+    document_ids_ = std::make_shared<const std::vector<int>>(std::move(document_ids));
+}
+
+bool IdSet::operator()(int document_id, DocumentStatus, int) const {
+    return std::binary_search(document_ids_->begin(), document_ids_->end(), document_id);
+}
+
+const std::vector<int>& IdSet::GetDocumentIds() const {
+    return *document_ids_;
+}
\ No newline at end of file
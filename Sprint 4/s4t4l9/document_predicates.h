@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "document.h"
+
+// Предикаты документов, которые SearchServer распознает на этапе компиляции.
+// Каждый из них вызывается как обычный предикат (ID, статус, рейтинг), но SearchServer
+// проверяет статус и рейтинг встроенным сравнением со своими столбцами, без вызова
+// предиката на каждое вхождение, а набор ID переводит в маску по номерам документов
+// один раз на запрос
+
+// Документы с заданным статусом
+struct ByStatus {
+    DocumentStatus status;
+
+    bool operator()(int document_id, DocumentStatus document_status, int rating) const;
+
+    // Проверка по столбцам SearchServer, определена в заголовке, чтобы встраиваться в цикл поиска
+    bool MatchesColumns(DocumentStatus document_status, int) const {
+        return document_status == status;
+    }
+};
+
+// Документы с рейтингом из [min_rating, max_rating]
+struct RatingRange {
+    int min_rating;
+    int max_rating;
+
+    bool operator()(int document_id, DocumentStatus status, int rating) const;
+
+    // Одно беззнаковое сравнение вместо двух условных переходов, плохо предсказуемых в цикле поиска
+    bool MatchesColumns(DocumentStatus, int rating) const {
+        return min_rating <= max_rating && static_cast<unsigned>(rating) - static_cast<unsigned>(min_rating)
+            <= static_cast<unsigned>(max_rating) - static_cast<unsigned>(min_rating);
+    }
+};
+
+// Документы из заданного набора ID. Набор хранится отсортированным и делится между копиями предиката
+class IdSet {
+    public:
+        explicit IdSet(std::vector<int> document_ids);
+
+        bool operator()(int document_id, DocumentStatus status, int rating) const;
+
+        // ID проверяются по маске, которую SearchServer строит по GetDocumentIds
+        bool MatchesColumns(DocumentStatus, int) const {
+            return true;
+        }
+
+        const std::vector<int>& GetDocumentIds() const;
+
+    private:
+        std::shared_ptr<const std::vector<int>> document_ids_;
+};
+
+// Документы, удовлетворяющие обоим предикатам
+template <typename Lhs, typename Rhs>
+struct AllOf {
+    Lhs lhs;
+    Rhs rhs;
+
+    bool operator()(int document_id, DocumentStatus status, int rating) const {
+        return lhs(document_id, status, rating) && rhs(document_id, status, rating);
+    }
+
+    bool MatchesColumns(DocumentStatus status, int rating) const {
+        return lhs.MatchesColumns(status, rating) && rhs.MatchesColumns(status, rating);
+    }
+};
+
+// Признак предиката, распознаваемого SearchServer
+template <typename Predicate>
+struct IsDocumentFilter : std::false_type {};
+
+template <>
+struct IsDocumentFilter<ByStatus> : std::true_type {};
+
+template <>
+struct IsDocumentFilter<RatingRange> : std::true_type {};
+
+template <>
+struct IsDocumentFilter<IdSet> : std::true_type {};
+
+template <typename Lhs, typename Rhs>
+struct IsDocumentFilter<AllOf<Lhs, Rhs>> : std::bool_constant<IsDocumentFilter<Lhs>::value
+    && IsDocumentFilter<Rhs>::value> {};
+
+template <typename Predicate>
+inline constexpr bool IS_DOCUMENT_FILTER = IsDocumentFilter<std::decay_t<Predicate>>::value;
+
+// Признак фильтра, ограничивающего набор ID, для него SearchServer строит маску
+template <typename Predicate>
+struct HasIdSet : std::false_type {};
+
+template <>
+struct HasIdSet<IdSet> : std::true_type {};
+
+template <typename Lhs, typename Rhs>
+struct HasIdSet<AllOf<Lhs, Rhs>> : std::bool_constant<HasIdSet<Lhs>::value || HasIdSet<Rhs>::value> {};
+
+// Сочетание предикатов: ByStatus{DocumentStatus::ACTUAL} && RatingRange{5, 10}
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<IS_DOCUMENT_FILTER<Lhs> && IS_DOCUMENT_FILTER<Rhs>>>
+AllOf<Lhs, Rhs> operator&&(const Lhs& lhs, const Rhs& rhs) {
+    return {lhs, rhs};
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "forward_index.h"
+
+#include <utility>
+
+ForwardIndex::ForwardIndex(ForwardIndex&& other) noexcept
+        : is_built_(other.is_built_.load())
+        , documents_(std::move(other.documents_)) {
+}
+
+ForwardIndex& ForwardIndex::operator=(ForwardIndex&& other) noexcept {
+    if (this != &other) {
+        is_built_.store(other.is_built_.load());
+        documents_ = std::move(other.documents_);
+    }
+    return *this;
+}
+
+void ForwardIndex::Defer() {
+    documents_.clear();
+    is_built_.store(false, std::memory_order_release);
+}
+
+bool ForwardIndex::IsBuilt() const {
+    return is_built_.load(std::memory_order_acquire);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string_view>
+
+// Прямой индекс: ID документа -> частоты его слов. Сборку можно отложить: тогда индекс
+// собирается функцией build при первом обращении. Сборка защищена мьютексом, поэтому
+// первое обращение может прийти из константных методов, выполняемых параллельно
+class ForwardIndex {
+    public:
+        using WordFreqs = std::map<std::string_view, double>;
+        using Documents = std::map<int, WordFreqs>;
+
+        ForwardIndex() = default;
+
+        // Мьютекс не перемещается, поэтому перемещение переносит только состояние индекса
+        ForwardIndex(ForwardIndex&& other) noexcept;
+
+        ForwardIndex& operator=(ForwardIndex&& other) noexcept;
+
+        // Сброс индекса с отложенной сборкой
+        void Defer();
+
+        bool IsBuilt() const;
+
+        // Индекс, при отложенной сборке сначала заполняемый вызовом build(documents)
+        template <typename Build>
+        const Documents& Get(Build build) const;
+
+        template <typename Build>
+        Documents& Get(Build build);
+
+    private:
+        mutable std::mutex mutex_;
+        mutable std::atomic<bool> is_built_{true};
+        mutable Documents documents_;
+};
+
+// Реализация шаблонных функций
+
+template <typename Build>
+const ForwardIndex::Documents& ForwardIndex::Get(Build build) const {
+    if (!is_built_.load(std::memory_order_acquire)) {
+        std::lock_guard guard(mutex_);
+        // Пока ждали мьютекс, индекс мог собрать другой поток
+        if (!is_built_.load(std::memory_order_relaxed)) {
+            build(documents_);
+            is_built_.store(true, std::memory_order_release);
+        }
+    }
+    return documents_;
+}
+
+template <typename Build>
+ForwardIndex::Documents& ForwardIndex::Get(Build build) {
+    static_cast<const ForwardIndex&>(*this).Get(build);
+    return documents_;
+}
\ No newline at end of file
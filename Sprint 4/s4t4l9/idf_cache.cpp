@@ -0,0 +1,41 @@
+#include "idf_cache.h"
+
+IdfCache::Entry::Entry(const Entry& other)
+        : epoch(other.epoch.load(std::memory_order_relaxed))
+        , value(other.value) {
+}
+
+IdfCache::Entry& IdfCache::Entry::operator=(const Entry& other) {
+    epoch.store(other.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    value = other.value;
+    return *this;
+}
+
+IdfCache::IdfCache(const IdfCache& other)
+        : epoch_(other.epoch_)
+        , entries_(other.entries_) {
+}
+
+IdfCache& IdfCache::operator=(const IdfCache& other) {
+    if (this != &other) {
+        epoch_ = other.epoch_;
+        entries_ = other.entries_;
+    }
+    return *this;
+}
+
+void IdfCache::Invalidate(std::size_t term_count) {
+    ++epoch_;
+    entries_.resize(term_count);
+}
+
+std::optional<double> IdfCache::Get(TermId term_id) const {
+    if (term_id >= entries_.size() || IsStale(term_id) || std::isnan(entries_[term_id].value)) {
+        return std::nullopt;
+    }
+    return entries_[term_id].value;
+}
+
+bool IdfCache::IsStale(TermId term_id) const {
+    return term_id < entries_.size() && entries_[term_id].epoch.load(std::memory_order_acquire) != epoch_;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "posting_list.h"
+
+// Политика обновления закэшированных IDF
+enum class IdfRefreshPolicy {
+    // Пересчет сразу после каждого добавления или удаления документа
+    EAGER,
+    // Пересчет IDF слов запроса при первом запросе с ними после изменения индекса
+    LAZY,
+    // Пересчет только по явному вызову в конце пакета добавлений
+    EPOCH,
+};
+
+// Кэш IDF по ID терма. У каждого значения есть отметка эпохи, в которую оно посчитано:
+// Invalidate начинает новую эпоху, и значения с прежней отметкой считаются устаревшими.
+// Пересчет отдельных термов защищен мьютексом, поэтому его можно запускать из константных
+// методов поиска, выполняемых параллельно
+class IdfCache {
+    public:
+        IdfCache() = default;
+
+        IdfCache(const IdfCache& other);
+
+        IdfCache& operator=(const IdfCache& other);
+
+        // Новая эпоха для термов [0, term_count): все значения устаревают, пересчет не выполняется
+        void Invalidate(std::size_t term_count);
+
+        // Пересчет значений для термов [0, term_count), compute(term_id) возвращает IDF терма
+        // или NaN, если терм сейчас не встречается ни в одном документе
+        template <typename Compute>
+        void Refresh(std::size_t term_count, Compute compute);
+
+        // Пересчет устаревших значений термов term_ids, O(колличество термов). Термы за пределами кэша пропускаются
+        template <typename TermIds, typename Compute>
+        void RefreshIfStale(const TermIds& term_ids, Compute compute);
+
+        // Значение, посчитанное в текущую эпоху, или nullopt
+        std::optional<double> Get(TermId term_id) const;
+
+    private:
+        struct Entry {
+            Entry() = default;
+
+            Entry(const Entry& other);
+
+            Entry& operator=(const Entry& other);
+
+            // Эпоха записывается после значения, поэтому поток, увидевший текущую эпоху, видит и значение
+            std::atomic<std::uint64_t> epoch{0};
+            double value = 0.0;
+        };
+
+        std::mutex mutex_;
+        // Эпоха меняется только в неконстантных методах сервера, когда поиск не выполняется.
+        // Отметки записей начинаются с 0, поэтому новые записи сразу устаревшие
+        std::uint64_t epoch_ = 1;
+        std::vector<Entry> entries_;
+
+        bool IsStale(TermId term_id) const;
+};
+
+// Реализация шаблонных функций
+
+template <typename Compute>
+void IdfCache::Refresh(std::size_t term_count, Compute compute) {
+    std::lock_guard guard(mutex_);
+    entries_.resize(term_count);
+    for (std::size_t term_id = 0; term_id < term_count; ++term_id) {
+        entries_[term_id].value = compute(static_cast<TermId>(term_id));
+        entries_[term_id].epoch.store(epoch_, std::memory_order_release);
+    }
+}
+
+template <typename TermIds, typename Compute>
+void IdfCache::RefreshIfStale(const TermIds& term_ids, Compute compute) {
+    bool has_stale = false;
+    for (const TermId term_id : term_ids) {
+        has_stale = has_stale || IsStale(term_id);
+    }
+    if (!has_stale) {
+        return;
+    }
+    std::lock_guard guard(mutex_);
+    for (const TermId term_id : term_ids) {
+        // Пока ждали мьютекс, значение мог пересчитать другой поток
+        if (IsStale(term_id)) {
+            entries_[term_id].value = compute(term_id);
+            entries_[term_id].epoch.store(epoch_, std::memory_order_release);
+        }
+    }
+}
\ No newline at end of file
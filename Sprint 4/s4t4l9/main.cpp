@@ -1,10 +1,19 @@
+// Сборка: g++ -std=c++17 -O2 *.cpp -ltbb. Параллельные алгоритмы <execution> в libstdc++
+// выполняются поверх Intel TBB, без -ltbb программа не линкуется.
+// Запуск без аргументов выполняет пример, с аргументом --benchmark - еще и бенчмарки,
+// с аргументом --stress - еще и стресс-тест ConcurrentSearchServer
+
+#include <string_view>
+
+#include "benchmark.h"
 #include "paginator.h"
 #include "request_queue.h"
 #include "search_server.h"
+#include "stress_test.h"
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
     SearchServer search_server("and in at"s);
     RequestQueue request_queue(search_server);
     search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
@@ -23,5 +32,35 @@ int main() {
     // первый запрос удален, 1437 запросов с нулевым результатом
     request_queue.AddFindRequest("sparrow"s);
     cout << "Total empty requests: "s << request_queue.GetNoResultRequests() << endl;
+
+    // Стресс-тест гоняет десяток потоков несколько секунд, поэтому тоже запускается по флагу
+    if (argc >= 2 && argv[1] == "--stress"sv) {
+        RunConcurrentStressTest();
+        return 0;
+    }
+
+    // Бенчмарки идут десятки секунд и пишут снимок во временный каталог, поэтому запускаются по флагу
+    if (argc < 2 || argv[1] != "--benchmark"sv) {
+        return 0;
+    }
+    BenchmarkParallelFindTopDocuments();
+    BenchmarkProcessQueries();
+    BenchmarkPostingLists();
+    BenchmarkQueryParsing();
+    BenchmarkMinusWords();
+    BenchmarkSnapshot();
+    BenchmarkMappedSnapshot();
+    BenchmarkShardedSearchServer();
+    BenchmarkConcurrentSearchServer();
+    BenchmarkAddDocuments();
+    BenchmarkMaxScore();
+    BenchmarkQueryResultCache();
+    BenchmarkStatusFilters();
+    BenchmarkDocumentPredicates();
+    BenchmarkPhraseQueries();
+    BenchmarkPrefixQueries();
+    BenchmarkRelevanceModels();
+    BenchmarkPostingIntersection();
+    BenchmarkTermLookup();
     return 0;
 } 
\ No newline at end of file
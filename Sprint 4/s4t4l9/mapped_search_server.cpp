@@ -0,0 +1,127 @@
+#include "mapped_search_server.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+MappedSearchServer::MappedSearchServer(const std::string& path, bool verify_checksum)
+    : reader_(path, verify_checksum)
+    , stop_words_(ReadStopWords())
+    , term_count_(reader_.Count(&SnapshotHeader::term_offsets) - 1)
+    , term_offsets_(reader_.Section<std::uint64_t>(&SnapshotHeader::term_offsets))
+    , term_chars_(reader_.Section<char>(&SnapshotHeader::term_chars))
+    , posting_block_offsets_(reader_.Section<std::uint64_t>(&SnapshotHeader::posting_block_offsets))
+    , posting_blocks_(reader_.Section<PostingBlock>(&SnapshotHeader::posting_blocks))
+    , posting_data_(reader_.Section<std::uint8_t>(&SnapshotHeader::posting_data))
+    , document_count_(reader_.Count(&SnapshotHeader::document_ids))
+    , document_ids_(reader_.Section<std::int32_t>(&SnapshotHeader::document_ids))
+    , document_ratings_(reader_.Section<std::int32_t>(&SnapshotHeader::document_ratings))
+    , document_statuses_(reader_.Section<std::uint8_t>(&SnapshotHeader::document_statuses))
+    , document_word_counts_(reader_.Section<std::uint32_t>(&SnapshotHeader::document_word_counts)) {
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    std::size_t max_count) const {
+    return FindTopDocuments(raw_query, ByStatus{status}, max_count);
+}
+
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+int MappedSearchServer::GetDocumentCount() const {
+    return static_cast<int>(document_count_);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> MappedSearchServer::MatchDocument(
+    std::string_view raw_query, int document_id) const {
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, stop_words_, &query_buffer.resource);
+    CheckSupportedQuery(query);
+    const auto ordinal = FindDocument(document_id);
+    if (!ordinal) {
+        throw std::out_of_range("Document with this ID does not exist");
+    }
+    const auto status = static_cast<DocumentStatus>(document_statuses_[*ordinal]);
+    std::vector<std::string_view> matched_words;
+
+    for (const std::string_view word : query.minus_words) {
+        const auto term = FindTerm(word);
+        if (term && GetPostings(*term).FindTermCount(*ordinal)) {
+            return {matched_words, status};
+        }
+    }
+    for (const std::string_view word : query.plus_words) {
+        const auto term = FindTerm(word);
+        if (term && GetPostings(*term).FindTermCount(*ordinal)) {
+            matched_words.push_back(GetTerm(*term));
+        }
+    }
+    return {matched_words, status};
+}
+
+std::set<std::string, std::less<>> MappedSearchServer::ReadStopWords() const {
+    std::set<std::string, std::less<>> stop_words;
+    for (std::size_t i = 0; i + 1 < reader_.Count(&SnapshotHeader::stop_word_offsets); ++i) {
+        stop_words.emplace(reader_.String(&SnapshotHeader::stop_word_offsets, &SnapshotHeader::stop_word_chars, i));
+    }
+    return stop_words;
+}
+
+std::string_view MappedSearchServer::GetTerm(std::size_t term) const {
+    return {term_chars_ + term_offsets_[term], term_offsets_[term + 1] - term_offsets_[term]};
+}
+
+std::optional<std::size_t> MappedSearchServer::FindTerm(std::string_view word) const {
+    std::size_t lower = 0;
+    std::size_t upper = term_count_;
+    while (lower < upper) {
+        const std::size_t middle = lower + (upper - lower) / 2;
+        if (GetTerm(middle) < word) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+    if (lower < term_count_ && GetTerm(lower) == word) {
+        return lower;
+    }
+    return std::nullopt;
+}
+
+CompressedPostings MappedSearchServer::GetPostings(std::size_t term) const {
+    const std::uint64_t begin = posting_block_offsets_[term];
+    return {posting_blocks_ + begin, static_cast<std::size_t>(posting_block_offsets_[term + 1] - begin),
+        posting_data_};
+}
+
+std::optional<DocumentOrdinal> MappedSearchServer::FindDocument(int document_id) const {
+    const std::int32_t* it = std::lower_bound(document_ids_, document_ids_ + document_count_, document_id);
+    if (it == document_ids_ + document_count_ || *it != document_id) {
+        return std::nullopt;
+    }
+    return static_cast<DocumentOrdinal>(it - document_ids_);
+}
+
+// IDF считается по тем же данным и той же формуле, что и в SearchServer
+std::vector<std::pair<CompressedPostings, double>> MappedSearchServer::GetPlusWordPostings(
+    const Query& query) const {
+    std::vector<std::pair<CompressedPostings, double>> postings;
+    postings.reserve(query.plus_words.size());
+    for (const std::string_view word : query.plus_words) {
+        if (const auto term = FindTerm(word)) {
+            const CompressedPostings term_postings = GetPostings(*term);
+            postings.push_back({term_postings, std::log(static_cast<double>(document_count_) / static_cast<double>(term_postings.size()))});
+        }
+    }
+    return postings;
+}
+
+void MappedSearchServer::CheckSupportedQuery(const Query& query) {
+    if (!query.proximity_constraints.empty()) {
+        throw std::invalid_argument("Snapshots have no positions for phrase and NEAR queries");
+    }
+    if (!query.plus_prefixes.empty() || !query.minus_prefixes.empty()) {
+        throw std::invalid_argument("Prefix queries are not supported for mapped snapshots");
+    }
+}
\ No newline at end of file
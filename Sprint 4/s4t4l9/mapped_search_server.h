@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "compressed_postings.h"
+#include "document.h"
+#include "document_bitset.h"
+#include "posting_list.h"
+#include "query.h"
+#include "relevance_accumulator.h"
+#include "search_server.h"
+#include "snapshot.h"
+#include "top_documents.h"
+
+// Поисковый сервер только для чтения поверх снимка, отображенного в память.
+// Словарь, списки вхождений и таблица документов читаются прямо из файла без копирования,
+// поэтому процессы, открывшие один снимок, делят его страницы через кэш ОС
+class MappedSearchServer {
+    
+    public:
+        // Проверка контрольной суммы читает файл целиком, поэтому по умолчанию выключена:
+        // снимок проверяется один раз при публикации, а рабочий процесс только отображает его
+        explicit MappedSearchServer(const std::string& path, bool verify_checksum = false);
+
+        template <typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+            std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+        int GetDocumentCount() const;
+
+        // Найденные слова ссылаются на отображенный файл и живут, пока жив сервер
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+            int document_id) const;
+
+    private:
+        SnapshotReader reader_;
+        // Стоп-слов немного, для разбора запроса они нужны в виде множества
+        const std::set<std::string, std::less<>> stop_words_;
+
+        std::size_t term_count_;
+        const std::uint64_t* term_offsets_;
+        const char* term_chars_;
+        const std::uint64_t* posting_block_offsets_;
+        const PostingBlock* posting_blocks_;
+        const std::uint8_t* posting_data_;
+
+        std::size_t document_count_;
+        const std::int32_t* document_ids_;
+        const std::int32_t* document_ratings_;
+        const std::uint8_t* document_statuses_;
+        const std::uint32_t* document_word_counts_;
+
+        std::set<std::string, std::less<>> ReadStopWords() const;
+
+        std::string_view GetTerm(std::size_t term) const;
+
+        // Двоичный поиск терма в отсортированном словаре снимка
+        std::optional<std::size_t> FindTerm(std::string_view word) const;
+
+        // Сжатый список вхождений терма внутри файла
+        CompressedPostings GetPostings(std::size_t term) const;
+
+        // Номер документа совпадает с его позицией в отсортированной таблице ID
+        std::optional<DocumentOrdinal> FindDocument(int document_id) const;
+
+        std::vector<std::pair<CompressedPostings, double>> GetPlusWordPostings(const Query& query) const;
+
+        // В снимке нет позиций, поэтому фразы и NEAR/k не поддерживаются. Префиксы тоже не поддерживаются:
+        // объединение сжатых списков слов префикса пришлось бы распаковывать целиком
+        static void CheckSupportedQuery(const Query& query);
+
+        template <typename DocumentPredicate>
+        void FindAllDocuments(const Query& query, DocumentPredicate& document_predicate,
+            TopDocuments& top_documents) const;
+};
+
+// Реализация шаблонных функций
+
+template <typename DocumentPredicate>
+std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, stop_words_, &query_buffer.resource);
+    CheckSupportedQuery(query);
+
+    TopDocuments top_documents(max_count);
+    FindAllDocuments(query, document_predicate, top_documents);
+    return top_documents.Extract();
+}
+
+// Тот же порядок обхода, что и в SearchServer, поэтому релевантность совпадает до бита
+template <typename DocumentPredicate>
+void MappedSearchServer::FindAllDocuments(const Query& query, DocumentPredicate& document_predicate,
+    TopDocuments& top_documents) const {
+
+    const auto upper = static_cast<DocumentOrdinal>(document_count_);
+    const auto plus_postings = GetPlusWordPostings(query);
+
+    static thread_local DocumentBitset excluded;
+    const bool has_excluded = !query.minus_words.empty();
+    if (has_excluded) {
+        excluded.Resize(document_count_);
+        excluded.Clear();
+        for (const std::string_view word : query.minus_words) {
+            if (const auto term = FindTerm(word)) {
+                GetPostings(*term).ForEach(0, upper, [](DocumentOrdinal ordinal, std::uint32_t) {
+                    excluded.Set(ordinal);
+                });
+            }
+        }
+    }
+
+    static thread_local DenseRelevanceAccumulator accumulator;
+    accumulator.Reset(0, upper);
+    for (const auto& [postings, inverse_document_freq] : plus_postings) {
+        const double idf = inverse_document_freq;
+        postings.ForEach(0, upper, [&](DocumentOrdinal ordinal, std::uint32_t term_count) {
+            if (has_excluded && excluded.Test(ordinal)) {
+                return;
+            }
+            if (document_predicate(document_ids_[ordinal], static_cast<DocumentStatus>(document_statuses_[ordinal]),
+                document_ratings_[ordinal])) {
+                accumulator.Add(ordinal, ComputeTermFreq(term_count, document_word_counts_[ordinal]) * idf);
+            }
+        });
+    }
+    accumulator.ForEach([&](DocumentOrdinal ordinal, double relevance) {
+        top_documents.Push({document_ids_[ordinal], relevance, document_ratings_[ordinal]});
+    });
+}
\ No newline at end of file
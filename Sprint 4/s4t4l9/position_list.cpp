@@ -0,0 +1,101 @@
+#include "position_list.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::size_t PositionList::size() const {
+    return size_;
+}
+
+void PositionList::Add(bool is_new_document, std::uint32_t position) {
+    if (is_new_document || size_ == 0) {
+        if (size_ % ENTRIES_PER_OFFSET == 0) {
+            offsets_.push_back(data_.size());
+        }
+        ++size_;
+        AppendVarint(position + 1);
+    } else {
+        // Запись дописывается на место своего нулевого байта
+        data_.pop_back();
+        AppendVarint(position - last_position_);
+    }
+    data_.push_back(0);
+    last_position_ = position;
+}
+
+void PositionList::AppendEntry(const PositionList& source, std::size_t index) {
+    if (size_ % ENTRIES_PER_OFFSET == 0) {
+        offsets_.push_back(data_.size());
+    }
+    ++size_;
+    const std::size_t begin = source.FindEntry(index);
+    data_.insert(data_.end(), source.data_.data() + begin, source.data_.data() + source.SkipEntry(begin));
+}
+
+void PositionList::RemoveEntries(const PostingList& postings) {
+    // Оставшиеся записи сдвигаются к началу, начала групп записей собираются заново
+    offsets_.clear();
+    std::size_t read = 0;
+    std::size_t write = 0;
+    std::size_t kept = 0;
+    for (std::size_t entry = 0; entry < size_; ++entry) {
+        const std::size_t end = SkipEntry(read);
+        if (!postings.IsRemoved(entry)) {
+            if (kept % ENTRIES_PER_OFFSET == 0) {
+                offsets_.push_back(write);
+            }
+            std::copy(data_.data() + read, data_.data() + end, data_.data() + write);
+            write += end - read;
+            ++kept;
+        }
+        read = end;
+    }
+    data_.resize(write);
+    size_ = kept;
+}
+
+void PositionList::Decode(std::size_t index, std::vector<std::uint32_t>& positions) const {
+    positions.clear();
+    std::uint32_t position = 0;
+    std::uint32_t value = 0;
+    int shift = 0;
+    for (std::size_t i = FindEntry(index); data_[i] != 0; ++i) {
+        value |= static_cast<std::uint32_t>(data_[i] & 0x7f) << shift;
+        if (data_[i] & 0x80) {
+            shift += 7;
+            continue;
+        }
+        position += value;
+        value = 0;
+        shift = 0;
+        // Первое значение записи - позиция + 1
+        positions.push_back(positions.empty() ? --position : position);
+    }
+}
+
+std::size_t PositionList::GetByteSize() const {
+    return offsets_.size() * sizeof(std::uint64_t) + data_.size();
+}
+
+std::size_t PositionList::FindEntry(std::size_t index) const {
+    std::size_t offset = offsets_[index / ENTRIES_PER_OFFSET];
+    for (std::size_t skipped = 0; skipped < index % ENTRIES_PER_OFFSET; ++skipped) {
+        offset = SkipEntry(offset);
+    }
+    return offset;
+}
+
+std::size_t PositionList::SkipEntry(std::size_t begin) const {
+    // Нулевой байт встречается только в конце записи: у остальных байтов либо взведен
+    // старший бит, либо они завершают положительное значение
+    const void* end = std::memchr(data_.data() + begin, 0, data_.size() - begin);
+    return static_cast<std::size_t>(static_cast<const std::uint8_t*>(end) - data_.data()) + 1;
+}
+
+void PositionList::AppendVarint(std::uint32_t value) {
+    while (value >= 0x80) {
+        data_.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data_.push_back(static_cast<std::uint8_t>(value));
+}
\ No newline at end of file
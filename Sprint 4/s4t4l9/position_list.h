@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "posting_list.h"
+
+// Позиции слова в документах его списка вхождений. Запись i соответствует i-му вхождению
+// PostingList того же терма. Запись - разности позиций в коде переменной длины (7 бит на байт),
+// первая позиция хранится как позиция + 1, поэтому все значения положительны и нулевой байт
+// завершает запись. Начало запоминается у каждой ENTRIES_PER_OFFSET-й записи, до остальных
+// записи пропускаются поиском нулевого байта
+class PositionList {
+    public:
+        static constexpr std::size_t ENTRIES_PER_OFFSET = 16;
+
+        // Количество записей
+        std::size_t size() const;
+
+        // Добавление позиции. is_new_document открывает новую запись, иначе позиция дописывается
+        // к записи, открытой последним вызовом Add. Позиции внутри записи должны возрастать
+        void Add(bool is_new_document, std::uint32_t position);
+
+        // Копирование записи index другого списка в конец этого
+        void AppendEntry(const PositionList& source, std::size_t index);
+
+        // Удаление записей, вхождения которых помечены удаленными в списке вхождений того же терма.
+        // Вызывается до уплотнения postings, один проход по данным
+        void RemoveEntries(const PostingList& postings);
+
+        // Распаковка позиций записи index по возрастанию
+        void Decode(std::size_t index, std::vector<std::uint32_t>& positions) const;
+
+        // Объем сжатых данных в байтах
+        std::size_t GetByteSize() const;
+
+    private:
+        std::size_t size_ = 0;
+        // Начало записей 0, ENTRIES_PER_OFFSET, 2 * ENTRIES_PER_OFFSET, ... в data_
+        std::vector<std::uint64_t> offsets_;
+        std::vector<std::uint8_t> data_;
+        std::uint32_t last_position_ = 0;
+
+        // Начало записи index в data_
+        std::size_t FindEntry(std::size_t index) const;
+
+        // Позиция сразу за нулевым байтом записи, начинающейся в begin
+        std::size_t SkipEntry(std::size_t begin) const;
+
+        void AppendVarint(std::uint32_t value);
+};
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "posting_intersection.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define POSTING_INTERSECTION_SSE2
+#endif
+
+std::size_t IntersectMerge(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < lhs_size && j < rhs_size) {
+        if (lhs[i] < rhs[j]) {
+            ++i;
+        } else if (rhs[j] < lhs[i]) {
+            ++j;
+        } else {
+            out[count++] = lhs[i];
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+std::size_t IntersectGalloping(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out) {
+    std::size_t count = 0;
+    std::size_t from = 0;
+    for (std::size_t i = 0; i < lhs_size && from < rhs_size; ++i) {
+        const DocumentOrdinal ordinal = lhs[i];
+        // Шаги удваиваются, пока не перешагнут искомый номер, затем двоичный поиск внутри шага
+        std::size_t step = 1;
+        std::size_t upper = from;
+        while (upper < rhs_size && rhs[upper] < ordinal) {
+            from = upper + 1;
+            upper += step;
+            step *= 2;
+        }
+        upper = std::min(upper, rhs_size);
+        from = static_cast<std::size_t>(std::lower_bound(rhs + from, rhs + upper, ordinal) - rhs);
+        if (from < rhs_size && rhs[from] == ordinal) {
+            out[count++] = ordinal;
+            ++from;
+        }
+    }
+    return count;
+}
+
+std::size_t IntersectSimd(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+    std::size_t j = 0;
+#ifdef POSTING_INTERSECTION_SSE2
+    while (i + 4 <= lhs_size && j + 4 <= rhs_size) {
+        const __m128i lhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        const __m128i rhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + j));
+        // Каждый номер блока lhs сравнивается со всеми номерами блока rhs
+        __m128i equal = _mm_cmpeq_epi32(lhs_block, rhs_block);
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(0, 3, 2, 1))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(1, 0, 3, 2))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(2, 1, 0, 3))));
+        // Последние номера блоков читаются до записи, out может совпадать с lhs
+        const DocumentOrdinal lhs_last = lhs[i + 3];
+        const DocumentOrdinal rhs_last = rhs[j + 3];
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+        while (mask != 0) {
+            out[count++] = lhs[i + static_cast<std::size_t>(__builtin_ctz(mask))];
+            mask &= mask - 1;
+        }
+        // Блок с меньшим последним номером дальше ничего не найдет, при равенстве сдвигаются оба
+        i += lhs_last <= rhs_last ? 4 : 0;
+        j += rhs_last <= lhs_last ? 4 : 0;
+    }
+#endif
+    return count + IntersectMerge(lhs + i, lhs_size - i, rhs + j, rhs_size - j, out + count);
+}
+
+std::size_t Intersect(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out) {
+    if (lhs_size == 0 || rhs_size / lhs_size >= GALLOPING_SIZE_RATIO) {
+        return IntersectGalloping(lhs, lhs_size, rhs, rhs_size, out);
+    }
+    return IntersectSimd(lhs, lhs_size, rhs, rhs_size, out);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+#include "posting_list.h"
+
+// Пересечение возрастающих массивов номеров документов без повторов. Результат записывается в out
+// по возрастанию, функции возвращают его длину. out должен вмещать min(lhs_size, rhs_size) номеров
+// и может совпадать с lhs: номер пишется не дальше позиции, из которой он прочитан
+
+// Слияние двумя указателями, O(lhs_size + rhs_size)
+std::size_t IntersectMerge(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out);
+
+// Поиск каждого номера короткого массива lhs в длинном rhs экспоненциальными шагами от предыдущей находки,
+// O(lhs_size * log(rhs_size / lhs_size)). Выгоден при сильно различающихся длинах
+std::size_t IntersectGalloping(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out);
+
+// Слияние блоками по 4 номера: блок lhs сравнивается с четырьмя циклическими сдвигами блока rhs
+// за 4 векторных сравнения SSE2. Без SSE2 сводится к IntersectMerge
+std::size_t IntersectSimd(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out);
+
+// Пересечение способом, подходящим для соотношения длин: при rhs_size / lhs_size не меньше
+// GALLOPING_SIZE_RATIO - IntersectGalloping, иначе IntersectSimd. lhs не длиннее rhs
+std::size_t Intersect(const DocumentOrdinal* lhs, std::size_t lhs_size,
+    const DocumentOrdinal* rhs, std::size_t rhs_size, DocumentOrdinal* out);
+
+// Соотношение длин, начиная с которого поиск экспоненциальными шагами быстрее блочного слияния
+constexpr std::size_t GALLOPING_SIZE_RATIO = 32;
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "posting_list.h"
+
+#include <algorithm>
+#include <cstddef>
+
+std::size_t PostingList::size() const {
+    return document_ordinals.size();
+}
+
+std::size_t PostingList::GetDocumentCount() const {
+    return document_ordinals.size() - removed_count;
+}
+
+void PostingList::Add(DocumentOrdinal ordinal, double term_freq) {
+    if (!document_ordinals.empty() && document_ordinals.back() == ordinal) {
+        term_freqs.back() += term_freq;
+        max_term_freq = std::max(max_term_freq, term_freqs.back());
+        return;
+    }
+    document_ordinals.push_back(ordinal);
+    term_freqs.push_back(term_freq);
+    max_term_freq = std::max(max_term_freq, term_freq);
+}
+
+void PostingList::Remove(DocumentOrdinal ordinal) {
+    const std::size_t pos = LowerBound(ordinal);
+    if (pos < document_ordinals.size() && document_ordinals[pos] == ordinal && !IsRemoved(pos)) {
+        // Частота вхождения всегда положительна, поэтому ноль отличает удаленное вхождение
+        term_freqs[pos] = 0.0;
+        ++removed_count;
+    }
+}
+
+bool PostingList::IsRemoved(std::size_t pos) const {
+    return term_freqs[pos] == 0.0;
+}
+
+bool PostingList::NeedsCompaction() const {
+    return removed_count * 2 > document_ordinals.size();
+}
+
+void PostingList::Compact() {
+    std::size_t kept = 0;
+    max_term_freq = 0.0;
+    for (std::size_t pos = 0; pos < document_ordinals.size(); ++pos) {
+        if (IsRemoved(pos)) {
+            continue;
+        }
+        document_ordinals[kept] = document_ordinals[pos];
+        term_freqs[kept] = term_freqs[pos];
+        max_term_freq = std::max(max_term_freq, term_freqs[pos]);
+        ++kept;
+    }
+    document_ordinals.resize(kept);
+    term_freqs.resize(kept);
+    removed_count = 0;
+}
+
+std::size_t PostingList::LowerBound(DocumentOrdinal ordinal) const {
+    return static_cast<std::size_t>(std::lower_bound(document_ordinals.begin(), document_ordinals.end(), ordinal)
+        - document_ordinals.begin());
+}
+
+std::size_t PostingList::LowerBound(DocumentOrdinal ordinal, std::size_t from) const {
+    std::size_t step = 1;
+    std::size_t upper = from;
+    while (upper < document_ordinals.size() && document_ordinals[upper] < ordinal) {
+        from = upper + 1;
+        upper += step;
+        step *= 2;
+    }
+    upper = std::min(upper, document_ordinals.size());
+    const auto begin = document_ordinals.begin();
+    return static_cast<std::size_t>(std::lower_bound(begin + static_cast<std::ptrdiff_t>(from),
+        begin + static_cast<std::ptrdiff_t>(upper), ordinal) - begin);
+}
+
+bool PostingList::Contains(DocumentOrdinal ordinal) const {
+    const std::size_t pos = LowerBound(ordinal);
+    return pos < document_ordinals.size() && document_ordinals[pos] == ordinal;
+}
\ No newline at end of file
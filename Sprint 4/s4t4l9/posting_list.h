@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Порядковый номер документа в индексе, выдается при добавлении по возрастанию
+using DocumentOrdinal = std::uint32_t;
+
+// Идентификатор терма в словаре индекса
+using TermId = std::uint32_t;
+
+// Список вхождений терма в виде структуры массивов:
+// номера документов по возрастанию и соответствующие им частоты терма.
+// Удаленное вхождение остается в массивах с нулевой частотой, пока список не уплотнят
+struct PostingList {
+    std::vector<DocumentOrdinal> document_ordinals;
+    std::vector<double> term_freqs;
+    // Верхняя оценка частоты терма в документах списка. После удаления документа
+    // не уменьшается до уплотнения, поэтому может быть больше фактического максимума
+    double max_term_freq = 0.0;
+    // Колличество удаленных вхождений, оставшихся в массивах
+    std::size_t removed_count = 0;
+
+    // Колличество вхождений в массивах вместе с удаленными
+    std::size_t size() const;
+
+    // Колличество документов, содержащих терм
+    std::size_t GetDocumentCount() const;
+
+    // Добавление вхождения. Документы поступают по возрастанию номера,
+    // повторное вхождение в тот же документ увеличивает частоту
+    void Add(DocumentOrdinal ordinal, double term_freq);
+
+    // Пометка вхождения документа с номером ordinal удаленным, если оно есть, O(log size)
+    void Remove(DocumentOrdinal ordinal);
+
+    // Помечено ли удаленным вхождение в позиции pos
+    bool IsRemoved(std::size_t pos) const;
+
+    // Удалена половина вхождений: уплотнение за O(size) приходится на size / 2 удалений
+    bool NeedsCompaction() const;
+
+    // Вычистка удаленных вхождений из массивов с пересчетом max_term_freq
+    void Compact();
+
+    // Позиция первого вхождения с номером документа не меньше ordinal
+    std::size_t LowerBound(DocumentOrdinal ordinal) const;
+
+    // То же, но поиск начинается с позиции from и идет экспоненциальными шагами,
+    // поэтому продвижение курсора на небольшое расстояние стоит O(log расстояния)
+    std::size_t LowerBound(DocumentOrdinal ordinal, std::size_t from) const;
+
+    // Содержит ли список документ с номером ordinal
+    bool Contains(DocumentOrdinal ordinal) const;
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "process_queries.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+#include "document_predicates.h"
+#include "top_documents.h"
+
+JoinedDocuments::JoinedDocuments(std::vector<Document> documents, std::vector<std::size_t> offsets)
+        : documents_(std::move(documents))
+        , offsets_(std::move(offsets)) {
+}
+
+JoinedDocuments::Iterator JoinedDocuments::begin() const {
+    return documents_.begin();
+}
+
+JoinedDocuments::Iterator JoinedDocuments::end() const {
+    return documents_.end();
+}
+
+std::size_t JoinedDocuments::size() const {
+    return documents_.size();
+}
+
+std::size_t JoinedDocuments::QueryCount() const {
+    return offsets_.size() - 1;
+}
+
+JoinedDocuments::Iterator JoinedDocuments::QueryBegin(std::size_t query_index) const {
+    return documents_.begin() + static_cast<std::ptrdiff_t>(offsets_.at(query_index));
+}
+
+JoinedDocuments::Iterator JoinedDocuments::QueryEnd(std::size_t query_index) const {
+    return documents_.begin() + static_cast<std::ptrdiff_t>(offsets_.at(query_index + 1));
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> results(queries.size());
+    std::transform(std::execution::par, queries.begin(), queries.end(), results.begin(),
+        [&search_server](const std::string& query) {
+            return search_server.FindTopDocuments(query);
+        });
+    return results;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server,
+    const std::vector<std::string>& queries) {
+    // Каждый запрос отбирает не больше MAX_RESULT_DOCUMENT_COUNT документов прямо в свой участок общего
+    // вектора, без промежуточного вектора на запрос. Затем участки сдвигаются вплотную друг к другу
+    std::vector<Document> documents(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    std::vector<std::size_t> offsets(queries.size() + 1, 0);
+    std::vector<std::size_t> query_indexes(queries.size());
+    std::iota(query_indexes.begin(), query_indexes.end(), std::size_t{0});
+    std::for_each(std::execution::par, query_indexes.begin(), query_indexes.end(),
+        [&](std::size_t query_index) {
+            TopDocuments top_documents(documents.data() + query_index * MAX_RESULT_DOCUMENT_COUNT,
+                MAX_RESULT_DOCUMENT_COUNT);
+            search_server.FindTopDocuments(std::execution::seq, queries[query_index],
+                ByStatus{DocumentStatus::ACTUAL}, top_documents);
+            offsets[query_index + 1] = top_documents.ExtractToStorage();
+        });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    // Участок запроса сдвигается только влево, поэтому уже сдвинутые документы не затираются
+    for (std::size_t query_index = 0; query_index < queries.size(); ++query_index) {
+        const auto from = documents.begin() + static_cast<std::ptrdiff_t>(query_index * MAX_RESULT_DOCUMENT_COUNT);
+        const auto count = static_cast<std::ptrdiff_t>(offsets[query_index + 1] - offsets[query_index]);
+        std::move(from, from + count, documents.begin() + static_cast<std::ptrdiff_t>(offsets[query_index]));
+    }
+    documents.resize(offsets.back());
+    return JoinedDocuments(std::move(documents), std::move(offsets));
+}
\ No newline at end of file
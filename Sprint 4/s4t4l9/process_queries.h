@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Результаты нескольких запросов в одном плоском векторе. Документы i-го запроса лежат
+// в диапазоне [offsets[i], offsets[i + 1]), обход идёт по непрерывной памяти без вложенных векторов
+class JoinedDocuments {
+    public:
+        using Iterator = std::vector<Document>::const_iterator;
+
+        JoinedDocuments(std::vector<Document> documents, std::vector<std::size_t> offsets);
+
+        Iterator begin() const;
+
+        Iterator end() const;
+
+        // Общее колличество документов во всех результатах
+        std::size_t size() const;
+
+        // Колличество запросов
+        std::size_t QueryCount() const;
+
+        // Документы query_index-го запроса
+        Iterator QueryBegin(std::size_t query_index) const;
+
+        Iterator QueryEnd(std::size_t query_index) const;
+
+    private:
+        std::vector<Document> documents_;
+        // offsets_[i] - начало результата i-го запроса, последний элемент - documents_.size()
+        std::vector<std::size_t> offsets_;
+};
+
+// Параллельная обработка пакета запросов, результат i-го запроса - i-й элемент
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+    const std::vector<std::string>& queries);
+
+// Параллельная обработка пакета запросов с плоским результатом
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server,
+    const std::vector<std::string>& queries);
\ No newline at end of file
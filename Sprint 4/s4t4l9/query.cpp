@@ -0,0 +1,190 @@
+#include "query.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "string_processing.h"
+
+namespace {
+
+constexpr std::string_view NEAR_PREFIX = "NEAR/";
+
+// Сортировка и удаление повторов
+void SortUnique(std::pmr::vector<std::string_view>& words) {
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+}
+
+bool IsNearOperator(std::string_view word) {
+    return word.substr(0, NEAR_PREFIX.size()) == NEAR_PREFIX;
+}
+
+// Расстояние k оператора NEAR/k
+std::uint32_t ParseNearDistance(std::string_view word) {
+    word.remove_prefix(NEAR_PREFIX.size());
+    if (word.empty() || word.size() > 9
+        || !std::all_of(word.begin(), word.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        throw std::invalid_argument("NEAR operator must have a numeric distance");
+    }
+    std::uint32_t distance = 0;
+    for (const char c : word) {
+        distance = distance * 10 + static_cast<std::uint32_t>(c - '0');
+    }
+    if (distance == 0) {
+        throw std::invalid_argument("NEAR distance must be positive");
+    }
+    return distance;
+}
+
+} // namespace
+
+Query::Query(std::pmr::memory_resource* resource)
+        : plus_words(resource)
+        , minus_words(resource)
+        , proximity_words(resource)
+        , proximity_constraints(resource)
+        , plus_prefixes(resource)
+        , minus_prefixes(resource) {
+}
+
+// Парсинг слова запроса
+QueryWord ParseQueryWord(std::string_view text, const std::set<std::string, std::less<>>& stop_words) {
+    bool is_minus = false;
+    
+    if(!IsValidWord(text)){
+        throw std::invalid_argument("The request has invalid characters");
+    }
+
+    if((text[0] == '-' && text.size() == 1) || (text[0] == '-' && text[1] == '-')){
+        throw std::invalid_argument("The query has extra characters before or after the word");
+    }
+
+    if (text[0] == '-') {
+        is_minus = true;
+        text.remove_prefix(1);
+    }
+    return {text, is_minus, stop_words.count(text) > 0};
+}
+
+// Парсинг запроса
+Query ParseQuery(std::string_view text, const std::set<std::string, std::less<>>& stop_words,
+    std::pmr::memory_resource* resource) {
+    Query query(resource);
+
+    // Резервируем память сразу под все слова, чтобы векторы не перевыделялись в буфере
+    std::size_t word_count = 0;
+    bool has_proximity = false;
+    bool has_prefix = false;
+    ForEachWord(text, [&word_count, &has_proximity, &has_prefix](std::string_view word) {
+        ++word_count;
+        has_proximity = has_proximity || word.front() == '"' || IsNearOperator(word);
+        has_prefix = has_prefix || word.back() == '*';
+    });
+    query.plus_words.reserve(word_count);
+    query.minus_words.reserve(word_count);
+    if (has_proximity) {
+        // Каждое слово входит не больше чем в два ограничения NEAR
+        query.proximity_words.reserve(2 * word_count);
+        query.proximity_constraints.reserve(word_count);
+    }
+    if (has_prefix) {
+        query.plus_prefixes.reserve(word_count);
+        query.minus_prefixes.reserve(word_count);
+    }
+
+    bool in_phrase = false;
+    std::size_t phrase_begin = 0;
+    // Левое слово ожидающего правого слова оператора NEAR и расстояние оператора
+    std::string_view near_word;
+    std::uint32_t near_distance = 0;
+    // Последнее слово вне фразы, которое может быть левым словом NEAR
+    std::string_view previous_word;
+
+    ForEachWord(text, [&](std::string_view word) {
+        if (IsNearOperator(word)) {
+            if (in_phrase || previous_word.empty()) {
+                throw std::invalid_argument("NEAR operator must follow a plus word outside a phrase");
+            }
+            near_word = previous_word;
+            near_distance = ParseNearDistance(word);
+            previous_word = {};
+            return;
+        }
+
+        const bool opens_phrase = !in_phrase && word.front() == '"';
+        if (opens_phrase) {
+            word.remove_prefix(1);
+            in_phrase = true;
+            phrase_begin = query.proximity_words.size();
+        }
+        const bool closes_phrase = in_phrase && !word.empty() && word.back() == '"';
+        if (closes_phrase) {
+            word.remove_suffix(1);
+        }
+        if (word.empty()) {
+            throw std::invalid_argument("The phrase has an empty word");
+        }
+
+        const QueryWord query_word = ParseQueryWord(word, stop_words);
+        if (in_phrase && query_word.is_minus) {
+            throw std::invalid_argument("The phrase has a minus word");
+        }
+        if (query_word.data.back() == '*') {
+            if (query_word.data.size() == 1) {
+                throw std::invalid_argument("The prefix query has an empty prefix");
+            }
+            if (in_phrase || near_distance > 0) {
+                throw std::invalid_argument("Prefix words are not allowed in phrases and NEAR");
+            }
+            const std::string_view prefix = query_word.data.substr(0, query_word.data.size() - 1);
+            (query_word.is_minus ? query.minus_prefixes : query.plus_prefixes).push_back(prefix);
+            previous_word = {};
+            return;
+        }
+        if (near_distance > 0) {
+            if (in_phrase || query_word.is_minus || query_word.is_stop) {
+                throw std::invalid_argument("NEAR operator must precede a plus word outside a phrase");
+            }
+            const std::size_t near_begin = query.proximity_words.size();
+            query.proximity_words.push_back(near_word);
+            query.proximity_words.push_back(query_word.data);
+            query.proximity_constraints.push_back({near_begin, near_begin + 2, false, near_distance});
+            near_distance = 0;
+        }
+        previous_word = in_phrase || query_word.is_minus || query_word.is_stop ? std::string_view{} : query_word.data;
+
+        if (!query_word.is_stop) {
+            if (query_word.is_minus) {
+                query.minus_words.push_back(query_word.data);
+            } else {
+                query.plus_words.push_back(query_word.data);
+                if (in_phrase) {
+                    query.proximity_words.push_back(query_word.data);
+                }
+            }
+        }
+
+        if (closes_phrase) {
+            in_phrase = false;
+            // Фраза из одного слова ничего не ограничивает
+            if (query.proximity_words.size() - phrase_begin >= 2) {
+                query.proximity_constraints.push_back({phrase_begin, query.proximity_words.size(), true, 0});
+            } else {
+                query.proximity_words.resize(phrase_begin);
+            }
+        }
+    });
+
+    if (in_phrase) {
+        throw std::invalid_argument("The phrase has no closing quote");
+    }
+    if (near_distance > 0) {
+        throw std::invalid_argument("NEAR operator must precede a plus word outside a phrase");
+    }
+
+    SortUnique(query.plus_words);
+    SortUnique(query.minus_words);
+    SortUnique(query.plus_prefixes);
+    SortUnique(query.minus_prefixes);
+    return query;
+}
\ No newline at end of file
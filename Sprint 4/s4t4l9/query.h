@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "posting_list.h"
+
+// Число слов обычного запроса, который разбирается в буфере без обращений к куче
+constexpr std::size_t QUERY_BUFFER_WORD_COUNT = 64;
+
+// Память буфера на одно слово запроса: plus_words и minus_words резервируются под все слова,
+// а ID термов плюс- и минус-слов вместе занимают не больше одного TermId на слово.
+// Фразы, NEAR и префиксы резервируют еще по вектору на слово, такие запросы вмещаются в буфер
+// короче, а остаток уходит в кучу
+constexpr std::size_t QUERY_BUFFER_BYTES_PER_WORD = 2 * sizeof(std::string_view) + sizeof(TermId);
+
+// Размер буфера на стеке, в котором разбирается запрос, с запасом на выравнивание векторов
+constexpr std::size_t QUERY_BUFFER_SIZE = QUERY_BUFFER_WORD_COUNT * QUERY_BUFFER_BYTES_PER_WORD + 64;
+
+// Буфер и ресурс памяти для разбора одного запроса
+struct QueryBuffer {
+    std::array<std::byte, QUERY_BUFFER_SIZE> data;
+    std::pmr::monotonic_buffer_resource resource{data.data(), data.size()};
+};
+
+// Ограничение на взаимное расположение слов запроса [word_begin, word_end) из Query::proximity_words.
+// Фраза "a b c" требует слов подряд и по порядку, a NEAR/k b - двух слов на расстоянии не больше k
+// в любом порядке. Стоп-слова в позициях не учитываются
+struct ProximityConstraint {
+    std::size_t word_begin;
+    std::size_t word_end;
+    bool is_phrase;
+    std::uint32_t max_distance;
+};
+
+// Разобранный запрос: плюс- и минус-слова отсортированы и не повторяются.
+// Слова ссылаются на текст запроса, поэтому запрос не должен пережить исходную строку
+struct Query {
+    explicit Query(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    std::pmr::vector<std::string_view> plus_words;
+    std::pmr::vector<std::string_view> minus_words;
+    // Слова фраз и NEAR в порядке запроса, они же входят в plus_words
+    std::pmr::vector<std::string_view> proximity_words;
+    std::pmr::vector<ProximityConstraint> proximity_constraints;
+    // Префиксы слов вида cat* без звездочки, отсортированы и не повторяются
+    std::pmr::vector<std::string_view> plus_prefixes;
+    std::pmr::vector<std::string_view> minus_prefixes;
+};
+
+struct QueryWord {
+    std::string_view data;
+    bool is_minus;
+    bool is_stop;
+};
+
+// Парсинг слова запроса
+QueryWord ParseQueryWord(std::string_view text, const std::set<std::string, std::less<>>& stop_words);
+
+// Парсинг запроса, память под слова берется из resource. Слова в кавычках - фраза,
+// NEAR/k между словами - ограничение на расстояние между ними, cat* - любое слово с префиксом cat
+Query ParseQuery(std::string_view text, const std::set<std::string, std::less<>>& stop_words,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
\ No newline at end of file
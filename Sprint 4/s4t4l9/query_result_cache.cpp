@@ -0,0 +1,103 @@
+#include "query_result_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+QueryResultCache::QueryResultCache(const SearchServer& search_server, std::size_t capacity,
+    std::size_t stripe_count)
+    : search_server_(search_server)
+    , stripe_capacity_(std::max<std::size_t>(1, (capacity + stripe_count - 1) / std::max<std::size_t>(1, stripe_count)))
+    , stripes_(std::max<std::size_t>(1, stripe_count)) {
+}
+
+std::vector<Document> QueryResultCache::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    std::size_t max_count) {
+    std::string key;
+    {
+        QueryBuffer query_buffer;
+        key = MakeKey(search_server_.ParseQuery(raw_query, &query_buffer.resource), status, max_count);
+    }
+    Stripe& stripe = stripes_[std::hash<std::string>{}(key) % stripes_.size()];
+    const std::uint64_t generation = search_server_.GetGeneration();
+
+    {
+        std::lock_guard guard(stripe.mutex);
+        SyncGeneration(stripe, generation);
+        const auto it = stripe.index.find(key);
+        if (it != stripe.index.end()) {
+            // Запись переносится в начало списка, итераторы индекса при этом не меняются
+            stripe.entries.splice(stripe.entries.begin(), stripe.entries, it->second);
+            ++hits_;
+            return it->second->documents;
+        }
+    }
+
+    // Поиск выполняется без блокировки, поэтому два потока могут одновременно посчитать
+    // один и тот же запрос. Результат второго тогда просто не сохраняется
+    ++misses_;
+    std::vector<Document> documents = search_server_.FindTopDocuments(raw_query, status, max_count);
+
+    std::lock_guard guard(stripe.mutex);
+    SyncGeneration(stripe, generation);
+    if (stripe.generation != generation || stripe.index.count(key) > 0) {
+        return documents;
+    }
+    stripe.entries.push_front({std::move(key), documents});
+    stripe.index.emplace(stripe.entries.front().key, stripe.entries.begin());
+    if (stripe.entries.size() > stripe_capacity_) {
+        stripe.index.erase(stripe.entries.back().key);
+        stripe.entries.pop_back();
+        ++evictions_;
+    }
+    return documents;
+}
+
+std::vector<Document> QueryResultCache::FindTopDocuments(std::string_view raw_query) {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+QueryResultCacheStats QueryResultCache::GetStats() const {
+    return {hits_.load(), misses_.load(), evictions_.load(), invalidations_.load()};
+}
+
+std::string QueryResultCache::MakeKey(const Query& query, DocumentStatus status, std::size_t max_count) {
+    std::string key = std::to_string(static_cast<int>(status)) + ' ' + std::to_string(max_count);
+    for (const std::string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (const std::string_view word : query.minus_words) {
+        key += " -";
+        key += word;
+    }
+    for (const std::string_view prefix : query.plus_prefixes) {
+        key += ' ';
+        key += prefix;
+        key += '*';
+    }
+    for (const std::string_view prefix : query.minus_prefixes) {
+        key += " -";
+        key += prefix;
+        key += '*';
+    }
+    // Ограничения близости отделены управляющим символом, которого нет в словах запроса
+    for (const ProximityConstraint& constraint : query.proximity_constraints) {
+        key += constraint.is_phrase ? "\1\"" : "\1NEAR/" + std::to_string(constraint.max_distance);
+        for (std::size_t i = constraint.word_begin; i < constraint.word_end; ++i) {
+            key += ' ';
+            key += query.proximity_words[i];
+        }
+    }
+    return key;
+}
+
+void QueryResultCache::SyncGeneration(Stripe& stripe, std::uint64_t generation) {
+    // Поиск, начатый до изменения индекса, не должен сбрасывать записи нового поколения
+    if (stripe.generation >= generation) {
+        return;
+    }
+    invalidations_ += stripe.entries.size();
+    stripe.index.clear();
+    stripe.entries.clear();
+    stripe.generation = generation;
+}
\ No newline at end of file
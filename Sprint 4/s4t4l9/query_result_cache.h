@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "query.h"
+#include "search_server.h"
+
+// Счетчики кэша выдачи
+struct QueryResultCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    // Записи, вытесненные из-за нехватки места
+    std::uint64_t evictions = 0;
+    // Записи, сброшенные после изменения индекса
+    std::uint64_t invalidations = 0;
+};
+
+// LRU-кэш выдачи FindTopDocuments перед SearchServer. Ключ - разобранный запрос
+// (отсортированные плюс- и минус-слова без стоп-слов), статус и max_count, поэтому
+// запросы, отличающиеся порядком слов или повторами, делят одну запись.
+// Кэш разбит на полосы со своими мьютексами, запросы в разные полосы не ждут друг друга.
+// Записи действительны, пока не изменилось поколение индекса
+class QueryResultCache {
+    public:
+        explicit QueryResultCache(const SearchServer& search_server, std::size_t capacity = 4096,
+            std::size_t stripe_count = 16);
+
+        // Можно вызывать из нескольких потоков, пока индекс не меняется
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+            std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT);
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query);
+
+        QueryResultCacheStats GetStats() const;
+
+    private:
+        struct Entry {
+            std::string key;
+            std::vector<Document> documents;
+        };
+
+        // Полоса кэша: список записей от недавно использованных к давно использованным
+        // и индекс по ключу, ключи индекса ссылаются на строки в записях списка
+        struct Stripe {
+            std::mutex mutex;
+            std::list<Entry> entries;
+            std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+            // Поколение индекса, для которого собраны записи полосы
+            std::uint64_t generation = 0;
+        };
+
+        const SearchServer& search_server_;
+        std::size_t stripe_capacity_;
+        std::deque<Stripe> stripes_;
+
+        std::atomic<std::uint64_t> hits_{0};
+        std::atomic<std::uint64_t> misses_{0};
+        std::atomic<std::uint64_t> evictions_{0};
+        std::atomic<std::uint64_t> invalidations_{0};
+
+        // Ключ записи: статус, max_count, плюс-слова и минус-слова с префиксом '-'
+        static std::string MakeKey(const Query& query, DocumentStatus status, std::size_t max_count);
+
+        // Сброс записей полосы, собранных для другого поколения индекса. Вызывается под мьютексом полосы
+        void SyncGeneration(Stripe& stripe, std::uint64_t generation);
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "relevance_accumulator.h"
+
+void DenseRelevanceAccumulator::Reset(DocumentOrdinal lower, DocumentOrdinal upper) {
+    for (const DocumentOrdinal ordinal : touched_) {
+        is_touched_[ordinal - lower_] = 0;
+    }
+    touched_.clear();
+
+    lower_ = lower;
+    const std::size_t size = upper - lower;
+    if (relevance_.size() < size) {
+        relevance_.resize(size);
+        is_touched_.resize(size, 0);
+    }
+}
+
+void DenseRelevanceAccumulator::Add(DocumentOrdinal ordinal, double relevance) {
+    const std::size_t index = ordinal - lower_;
+    if (is_touched_[index]) {
+        relevance_[index] += relevance;
+    } else {
+        is_touched_[index] = 1;
+        relevance_[index] = relevance;
+        touched_.push_back(ordinal);
+    }
+}
+
+void HashRelevanceAccumulator::Reset(DocumentOrdinal, DocumentOrdinal) {
+    for (const std::size_t pos : used_slots_) {
+        slots_[pos] = Slot{};
+    }
+    used_slots_.clear();
+}
+
+void HashRelevanceAccumulator::Add(DocumentOrdinal ordinal, double relevance) {
+    const std::size_t pos = FindSlot(ordinal);
+    Slot& slot = slots_[pos];
+    if (!slot.used) {
+        slot = {ordinal, relevance, true};
+        used_slots_.push_back(pos);
+        Grow();
+    } else {
+        slot.relevance += relevance;
+    }
+}
+
+std::size_t HashRelevanceAccumulator::FindSlot(DocumentOrdinal ordinal) const {
+    // Размер таблицы - степень двойки, поэтому остаток заменяется маской
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t pos = (ordinal * 0x9E3779B1u) & mask;
+    while (slots_[pos].used && slots_[pos].ordinal != ordinal) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void HashRelevanceAccumulator::Grow() {
+    if (used_slots_.size() * 2 <= slots_.size()) {
+        return;
+    }
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+
+    std::vector<std::size_t> old_used_slots;
+    old_used_slots.swap(used_slots_);
+    used_slots_.reserve(old_used_slots.size());
+
+    // Порядок used_slots_ сохраняется, чтобы обход шел в порядке добавления
+    for (const std::size_t old_pos : old_used_slots) {
+        const std::size_t pos = FindSlot(old_slots[old_pos].ordinal);
+        slots_[pos] = old_slots[old_pos];
+        used_slots_.push_back(pos);
+    }
+}
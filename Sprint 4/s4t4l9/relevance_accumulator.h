@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "posting_list.h"
+
+// Плотный аккумулятор релевантности: массив по номерам документов диапазона [lower, upper)
+// и список затронутых номеров. Сброс стоит O(затронутых), а не O(размера массива)
+class DenseRelevanceAccumulator {
+    public:
+        // Подготовка к новому запросу для номеров из диапазона [lower, upper)
+        void Reset(DocumentOrdinal lower, DocumentOrdinal upper);
+
+        void Add(DocumentOrdinal ordinal, double relevance);
+
+        // Обход документов с накопленной релевантностью
+        template <typename Callback>
+        void ForEach(Callback callback) const;
+
+    private:
+        DocumentOrdinal lower_ = 0;
+        std::vector<double> relevance_;
+        std::vector<std::uint8_t> is_touched_;
+        std::vector<DocumentOrdinal> touched_;
+};
+
+// Аккумулятор на хеш-таблице с открытой адресацией для разреженных номеров документов:
+// память пропорциональна числу затронутых документов, а не размеру диапазона
+class HashRelevanceAccumulator {
+    public:
+        void Reset(DocumentOrdinal lower, DocumentOrdinal upper);
+
+        void Add(DocumentOrdinal ordinal, double relevance);
+
+        template <typename Callback>
+        void ForEach(Callback callback) const;
+
+    private:
+        struct Slot {
+            DocumentOrdinal ordinal = 0;
+            double relevance = 0.0;
+            bool used = false;
+        };
+
+        static constexpr std::size_t INITIAL_CAPACITY = 1024;
+
+        std::vector<Slot> slots_ = std::vector<Slot>(INITIAL_CAPACITY);
+        std::vector<std::size_t> used_slots_;
+
+        // Позиция слота с номером ordinal или свободного слота для него
+        std::size_t FindSlot(DocumentOrdinal ordinal) const;
+
+        // Увеличение таблицы вдвое при заполнении больше чем наполовину
+        void Grow();
+};
+
+// Реализация шаблонных функций
+
+template <typename Callback>
+void DenseRelevanceAccumulator::ForEach(Callback callback) const {
+    for (const DocumentOrdinal ordinal : touched_) {
+        callback(ordinal, relevance_[ordinal - lower_]);
+    }
+}
+
+template <typename Callback>
+void HashRelevanceAccumulator::ForEach(Callback callback) const {
+    for (const std::size_t pos : used_slots_) {
+        callback(slots_[pos].ordinal, slots_[pos].relevance);
+    }
+}
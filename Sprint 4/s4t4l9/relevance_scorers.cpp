@@ -0,0 +1,8 @@
+#include "relevance_scorers.h"
+
+Bm25Scorer::Bm25Scorer(const double* length_norms, double average_length, double k1, double b)
+        : length_norms_(length_norms)
+        , saturation_(k1 + 1.0)
+        , length_weight_(k1 * (1.0 - b))
+        , average_length_weight_(average_length > 0.0 ? k1 * b / average_length : 0.0) {
+}
\ No newline at end of file
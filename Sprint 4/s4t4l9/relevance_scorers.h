@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+
+#include "posting_list.h"
+
+// Модель релевантности SearchServer
+enum class RelevanceModel {
+    // Частота слова в документе, умноженная на IDF
+    TF_IDF,
+    // Okapi BM25: вклад слова насыщается с ростом частоты и нормируется на длину документа
+    BM25,
+};
+
+// Параметры BM25 по умолчанию
+constexpr double BM25_K1 = 1.2;
+constexpr double BM25_B = 0.75;
+
+// Оценщики вклада слова в релевантность документа. SearchServer передает оценщик шаблонным параметром
+// в циклы обхода списков вхождений, поэтому вызов встраивается в цикл. Оценщик определяет:
+//     double Score(double term_freq, double inverse_document_freq, DocumentOrdinal ordinal) const
+//         вклад слова с частотой term_freq и IDF inverse_document_freq в документ с номером ordinal;
+//     double GetMaxScore(double max_term_freq, double inverse_document_freq) const
+//         верхнюю оценку Score по документам списка с частотами не выше max_term_freq, нужна для MaxScore
+
+// Релевантность TF-IDF
+struct TfIdfScorer {
+    double Score(double term_freq, double inverse_document_freq, DocumentOrdinal) const {
+        return term_freq * inverse_document_freq;
+    }
+
+    double GetMaxScore(double max_term_freq, double inverse_document_freq) const {
+        return std::max(0.0, max_term_freq * inverse_document_freq);
+    }
+};
+
+// Релевантность BM25 с IDF, общим с TF-IDF. Частота слова в индексе уже поделена на длину документа,
+// поэтому формула idf * (k1 + 1) * count / (count + k1 * (1 - b + b * length / average_length))
+// после деления на длину документа принимает вид idf * (k1 + 1) * tf / (tf + k1 * (1 - b) / length + k1 * b / average_length).
+// 1 / length - норма документа, которую SearchServer хранит в столбце по номеру документа
+class Bm25Scorer {
+    public:
+        Bm25Scorer(const double* length_norms, double average_length, double k1 = BM25_K1, double b = BM25_B);
+
+        double Score(double term_freq, double inverse_document_freq, DocumentOrdinal ordinal) const {
+            return inverse_document_freq * saturation_ * term_freq
+                / (term_freq + length_weight_ * length_norms_[ordinal] + average_length_weight_);
+        }
+
+        // Слагаемое с нормой документа неотрицательно, без него знаменатель только меньше
+        double GetMaxScore(double max_term_freq, double inverse_document_freq) const {
+            return std::max(0.0, inverse_document_freq * saturation_ * max_term_freq
+                / (max_term_freq + average_length_weight_));
+        }
+
+    private:
+        const double* length_norms_;
+        // k1 + 1
+        double saturation_;
+        // k1 * (1 - b)
+        double length_weight_;
+        // k1 * b / average_length
+        double average_length_weight_;
+};
\ No newline at end of file
@@ -6,13 +6,13 @@ RequestQueue::RequestQueue(const SearchServer& search_server)
             , empty_results_(0) {
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const  std::string& raw_query, DocumentStatus status) {
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentStatus status) {
     const auto result = search_server_.FindTopDocuments(raw_query, status);
     RequestQueue::AddRequest(result.size());
     return result;
 }
 
-std::vector<Document> RequestQueue::AddFindRequest(const  std::string& raw_query) {
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query) {
     const auto result = search_server_.FindTopDocuments(raw_query);
     RequestQueue::AddRequest(result.size());
     return result;
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "document.h"
@@ -14,11 +15,11 @@ class RequestQueue {
 
         // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
         template <typename DocumentPredicate>   
-        std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+        std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
 
-        std::vector<Document> AddFindRequest(const  std::string& raw_query, DocumentStatus status);
+        std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentStatus status);
         
-        std::vector<Document> AddFindRequest(const  std::string& raw_query);
+        std::vector<Document> AddFindRequest(std::string_view raw_query);
 
         // Возвращаем колличество пусты запросов
         int GetNoResultRequests() const;
@@ -54,7 +55,7 @@ class RequestQueue {
 
 // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
 template <typename DocumentPredicate>   
-std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
     const auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
     AddRequest(result.size());
     return result;
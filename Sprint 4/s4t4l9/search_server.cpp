@@ -1,85 +1,831 @@
 #include "search_server.h"
 
+#include <queue>
+#include <unordered_map>
+
+#include "compressed_postings.h"
+#include "snapshot.h"
+
+namespace {
+
+// Слова фразы стоят подряд: для некоторой позиции p первого слова k-е слово есть на позиции p + k
+bool HasPhrase(const std::vector<std::vector<std::uint32_t>>& word_positions, std::size_t word_count) {
+    std::vector<std::size_t> indexes(word_count, 0);
+    for (const std::uint32_t position : word_positions[0]) {
+        bool matches = true;
+        for (std::size_t word = 1; word < word_count && matches; ++word) {
+            const std::vector<std::uint32_t>& positions = word_positions[word];
+            std::size_t& index = indexes[word];
+            while (index < positions.size() && positions[index] < position + word) {
+                ++index;
+            }
+            if (index == positions.size()) {
+                return false;
+            }
+            matches = positions[index] == position + word;
+        }
+        if (matches) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Есть пара позиций слов на расстоянии не больше max_distance. Для одного и того же слова
+// пара составляется из двух разных вхождений
+bool HasNearPair(const std::vector<std::uint32_t>& lhs, const std::vector<std::uint32_t>& rhs,
+    std::uint32_t max_distance, bool is_same_word) {
+    if (is_same_word) {
+        for (std::size_t i = 1; i < lhs.size(); ++i) {
+            if (lhs[i] - lhs[i - 1] <= max_distance) {
+                return true;
+            }
+        }
+        return false;
+    }
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < lhs.size() && j < rhs.size()) {
+        const std::uint32_t distance = lhs[i] < rhs[j] ? rhs[j] - lhs[i] : lhs[i] - rhs[j];
+        if (distance <= max_distance) {
+            return true;
+        }
+        if (lhs[i] < rhs[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 SearchServer::SearchServer(const std::string& stop_words_text)
+    : SearchServer(std::string_view(stop_words_text)){
+}
+
+SearchServer::SearchServer(std::string_view stop_words_text)
     : SearchServer(SplitIntoWords(stop_words_text)){
 }
 
 // Функция добавления документов
-void SearchServer::AddDocument(int document_id, const std::string& document, DocumentStatus status,
+void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
                 const std::vector<int>& ratings) {
-    if(document_id < 0 || count(document_ids_.begin(), document_ids_.end(), document_id)){
+    if(document_id < 0 || documents_.count(document_id)){
         throw std::invalid_argument("Document ID is wrong or a document with this ID has already been added earlier");
     } 
 
-    const std::vector<std::string> words = SplitIntoWordsNoStop(document);
+    const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
+
+    // Проверяем все слова до изменения индекса, чтобы не оставить документ добавленным частично
+    if(!std::all_of(words.begin(), words.end(), IsValidWord)){
+        throw std::invalid_argument("The document has invalid characters");
+    }
+
     const double inv_word_count = 1.0 / words.size();
+    const auto ordinal = static_cast<DocumentOrdinal>(ordinal_to_document_id_.size());
+    // Отложенный прямой индекс соберется по спискам вхождений уже вместе с этим документом
+    ForwardIndex::WordFreqs* word_freqs = document_to_word_freqs_.IsBuilt()
+        ? &GetForwardIndex()[document_id] : nullptr;
             
-    for (const std::string& word : words) {
-        if(!IsValidWord(word)){
-            throw std::invalid_argument("The document has invalid characters");
+    for (std::uint32_t position = 0; position < words.size(); ++position) {
+        const TermId term_id = InternTerm(words[position]);
+        PostingList& postings = postings_[term_id];
+        if (has_positions_) {
+            // Позиция считается без стоп-слов, поэтому фраза со стоп-словом находит документ и без него
+            const bool is_new_document = postings.size() == 0 || postings.document_ordinals.back() != ordinal;
+            positions_[term_id].Add(is_new_document, position);
+        }
+        postings.Add(ordinal, inv_word_count);
+        if (word_freqs != nullptr) {
+            (*word_freqs)[term_pool_[term_id]] += inv_word_count;
         }
-        word_to_document_freqs_[word][document_id] += inv_word_count;
     }
             
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
-    document_ids_.push_back(document_id);
+    const int rating = ComputeAverageRating(ratings);
+    documents_.emplace(document_id, DocumentData{rating, status, ordinal, static_cast<std::uint32_t>(words.size())});
+    AppendOrdinal(document_id, status, rating, static_cast<std::uint32_t>(words.size()));
+    OnDocumentsChanged();
+}
+
+// Пакетное добавление документов, разбор выполняется параллельно
+void SearchServer::AddDocuments(const std::vector<DocumentToAdd>& documents) {
+    AddDocuments(std::execution::par, documents);
 }
 
 // Переопределение функции поиска топа документов с заданным статусом документов
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;});
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    std::size_t max_count) const {
+    return FindTopDocuments(raw_query, ByStatus{status}, max_count);
 }
 
 // Переопределение функции поиска топа документов 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+// Удаление документа
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+// Включение позиционного индекса. Для уже добавленных документов позиций нет,
+// поэтому включить их можно только у пустого сервера
+void SearchServer::EnablePositions() {
+    if (!ordinal_to_document_id_.empty()) {
+        throw std::logic_error("Positions must be enabled before documents are added");
+    }
+    has_positions_ = true;
+    positions_.resize(postings_.size());
+}
+
+bool SearchServer::HasPositions() const {
+    return has_positions_;
+}
+
+// Сохранение индекса в бинарный снимок. Документы перенумеровываются по возрастанию ID,
+// поэтому номер документа в снимке совпадает с его позицией в таблице документов.
+// Списки вхождений сжимаются, вместо частот хранятся колличества вхождений слова
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    SnapshotWriter writer;
+    writer.WriteStrings(&SnapshotHeader::stop_word_offsets, &SnapshotHeader::stop_word_chars, stop_words_);
+
+    std::vector<DocumentOrdinal> snapshot_ordinals(ordinal_to_document_id_.size());
+    std::vector<std::int32_t> document_ids;
+    std::vector<std::int32_t> document_ratings;
+    std::vector<std::uint8_t> document_statuses;
+    std::vector<std::uint32_t> document_word_counts;
+    for (const auto& [document_id, document_data] : documents_) {
+        snapshot_ordinals[document_data.ordinal] = static_cast<DocumentOrdinal>(document_ids.size());
+        document_ids.push_back(document_id);
+        document_ratings.push_back(document_data.rating);
+        document_statuses.push_back(static_cast<std::uint8_t>(document_data.status));
+        document_word_counts.push_back(document_data.word_count);
+    }
+
+    std::vector<std::string_view> terms;
+    std::vector<std::uint64_t> posting_block_offsets = {0};
+    std::vector<PostingBlock> posting_blocks;
+    std::vector<std::uint8_t> posting_data;
+    std::vector<std::pair<DocumentOrdinal, std::uint32_t>> term_postings;
+    std::vector<DocumentOrdinal> term_ordinals;
+    std::vector<std::uint32_t> term_counts;
+    for (const TermId term_id : GetSortedTermIds()) {
+        const PostingList& postings = postings_[term_id];
+        if (postings.GetDocumentCount() == 0) {
+            continue;
+        }
+        term_postings.clear();
+        for (std::size_t i = 0; i < postings.size(); ++i) {
+            if (postings.IsRemoved(i)) {
+                continue;
+            }
+            const DocumentOrdinal ordinal = snapshot_ordinals[postings.document_ordinals[i]];
+            term_postings.push_back({ordinal, ComputeTermCount(postings.term_freqs[i], document_word_counts[ordinal])});
+        }
+        std::sort(term_postings.begin(), term_postings.end());
+        term_ordinals.clear();
+        term_counts.clear();
+        for (const auto& [ordinal, term_count] : term_postings) {
+            term_ordinals.push_back(ordinal);
+            term_counts.push_back(term_count);
+        }
+        EncodePostings(term_ordinals.data(), term_counts.data(), term_postings.size(), posting_blocks, posting_data);
+        terms.push_back(term_pool_[term_id]);
+        posting_block_offsets.push_back(posting_blocks.size());
+    }
+
+    writer.WriteStrings(&SnapshotHeader::term_offsets, &SnapshotHeader::term_chars, terms);
+    writer.WriteSection(&SnapshotHeader::posting_block_offsets, posting_block_offsets.data(),
+        posting_block_offsets.size());
+    writer.WriteSection(&SnapshotHeader::posting_blocks, posting_blocks.data(), posting_blocks.size());
+    writer.WriteSection(&SnapshotHeader::posting_data, posting_data.data(), posting_data.size());
+    writer.WriteSection(&SnapshotHeader::document_ids, document_ids.data(), document_ids.size());
+    writer.WriteSection(&SnapshotHeader::document_ratings, document_ratings.data(), document_ratings.size());
+    writer.WriteSection(&SnapshotHeader::document_statuses, document_statuses.data(), document_statuses.size());
+    writer.WriteSection(&SnapshotHeader::document_word_counts, document_word_counts.data(),
+        document_word_counts.size());
+    writer.Save(path);
+}
+
+// Загрузка индекса из снимка: массивы копируются целиком, тексты документов не разбираются
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    const SnapshotReader reader(path);
+
+    std::vector<std::string_view> stop_words;
+    for (std::size_t i = 0; i + 1 < reader.Count(&SnapshotHeader::stop_word_offsets); ++i) {
+        stop_words.push_back(reader.String(&SnapshotHeader::stop_word_offsets, &SnapshotHeader::stop_word_chars, i));
+    }
+    SearchServer search_server(stop_words);
+
+    const std::size_t document_count = reader.Count(&SnapshotHeader::document_ids);
+    const auto* document_ids = reader.Section<std::int32_t>(&SnapshotHeader::document_ids);
+    const auto* document_ratings = reader.Section<std::int32_t>(&SnapshotHeader::document_ratings);
+    const auto* document_statuses = reader.Section<std::uint8_t>(&SnapshotHeader::document_statuses);
+    const auto* document_word_counts = reader.Section<std::uint32_t>(&SnapshotHeader::document_word_counts);
+
+    for (std::size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+        const int document_id = document_ids[ordinal];
+        if (document_id < 0 || (ordinal > 0 && document_id <= document_ids[ordinal - 1])) {
+            throw std::runtime_error("Snapshot document table is not sorted");
+        }
+        if (document_statuses[ordinal] > static_cast<std::uint8_t>(DocumentStatus::REMOVED)) {
+            throw std::runtime_error("Snapshot document status is out of range");
+        }
+        search_server.documents_.emplace_hint(search_server.documents_.end(), document_id,
+            DocumentData{document_ratings[ordinal], static_cast<DocumentStatus>(document_statuses[ordinal]),
+                static_cast<DocumentOrdinal>(ordinal), document_word_counts[ordinal]});
+        search_server.AppendOrdinal(document_id, static_cast<DocumentStatus>(document_statuses[ordinal]),
+            document_ratings[ordinal], document_word_counts[ordinal]);
+    }
+
+    const std::size_t term_count = reader.Count(&SnapshotHeader::term_offsets) - 1;
+    const auto* posting_block_offsets = reader.Section<std::uint64_t>(&SnapshotHeader::posting_block_offsets);
+    const auto* posting_blocks = reader.Section<PostingBlock>(&SnapshotHeader::posting_blocks);
+    const auto* posting_data = reader.Section<std::uint8_t>(&SnapshotHeader::posting_data);
+    search_server.postings_.resize(term_count);
+    search_server.term_ids_.Reserve(term_count);
+
+    // Сумма вхождений всех слов документа должна совпасть с его колличеством слов из таблицы документов
+    std::vector<std::uint64_t> document_term_counts(document_count, 0);
+    std::string_view previous_term;
+    for (std::size_t term_id = 0; term_id < term_count; ++term_id) {
+        const std::string_view snapshot_term = reader.String(&SnapshotHeader::term_offsets,
+            &SnapshotHeader::term_chars, term_id);
+        // Строгий порядок заодно гарантирует, что слова не повторяются
+        if (term_id > 0 && snapshot_term <= previous_term) {
+            throw std::runtime_error("Snapshot term dictionary is not sorted");
+        }
+        previous_term = snapshot_term;
+        const std::string& term = search_server.term_pool_.emplace_back(snapshot_term);
+        search_server.term_ids_.Emplace(term, static_cast<TermId>(term_id));
+
+        const CompressedPostings compressed_postings(posting_blocks + posting_block_offsets[term_id],
+            posting_block_offsets[term_id + 1] - posting_block_offsets[term_id], posting_data);
+        PostingList& postings = search_server.postings_[term_id];
+        postings.document_ordinals.reserve(compressed_postings.size());
+        postings.term_freqs.reserve(compressed_postings.size());
+
+        compressed_postings.ForEach(0, static_cast<DocumentOrdinal>(document_count),
+            [&](DocumentOrdinal ordinal, std::uint32_t occurrence_count) {
+                if (!postings.document_ordinals.empty() && postings.document_ordinals.back() >= ordinal) {
+                    throw std::runtime_error("Snapshot postings are not sorted");
+                }
+                // Нулевая частота в списке вхождений означает удаленное вхождение
+                if (occurrence_count == 0) {
+                    throw std::runtime_error("Snapshot posting has zero term count");
+                }
+                document_term_counts[ordinal] += occurrence_count;
+                postings.Add(ordinal, ComputeTermFreq(occurrence_count, document_word_counts[ordinal]));
+            });
+        if (postings.size() != compressed_postings.size()) {
+            throw std::runtime_error("Snapshot posting refers to unknown document");
+        }
+    }
+    for (std::size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+        if (document_term_counts[ordinal] != document_word_counts[ordinal]) {
+            throw std::runtime_error("Snapshot term counts don't match document word counts");
+        }
+    }
+
+    // Прямой индекс соберется по спискам вхождений при первом обращении, поэтому загрузка
+    // не строит словарь частот для каждого документа
+    search_server.document_to_word_freqs_.Defer();
+    search_server.OnDocumentsChanged();
+    return search_server;
+}
+
+// Объединение серверов с непересекающимися ID документов
+SearchServer SearchServer::Merge(const std::vector<const SearchServer*>& search_servers,
+    const std::set<int>& excluded_document_ids) {
+    if (search_servers.empty()) {
+        throw std::invalid_argument("No servers to merge");
+    }
+    SearchServer merged(search_servers.front()->stop_words_);
+    merged.has_positions_ = std::all_of(search_servers.begin(), search_servers.end(),
+        [](const SearchServer* search_server) { return search_server->has_positions_; });
+    const DocumentOrdinal removed = std::numeric_limits<DocumentOrdinal>::max();
+
+    for (const SearchServer* search_server : search_servers) {
+        // Новый номер документа по старому, у удаленных документов номера нет
+        std::vector<DocumentOrdinal> merged_ordinals(search_server->ordinal_to_document_id_.size(), removed);
+        for (DocumentOrdinal ordinal = 0; ordinal < merged_ordinals.size(); ++ordinal) {
+            const int document_id = search_server->ordinal_to_document_id_[ordinal];
+            const auto it = search_server->documents_.find(document_id);
+            if (it == search_server->documents_.end() || it->second.ordinal != ordinal
+                || excluded_document_ids.count(document_id) > 0) {
+                continue;
+            }
+            if (merged.documents_.count(document_id) > 0) {
+                throw std::invalid_argument("Merged servers contain the same document ID");
+            }
+            merged_ordinals[ordinal] = static_cast<DocumentOrdinal>(merged.ordinal_to_document_id_.size());
+            merged.documents_.emplace(document_id,
+                DocumentData{it->second.rating, it->second.status, merged_ordinals[ordinal], it->second.word_count});
+            merged.AppendOrdinal(document_id, it->second.status, it->second.rating, it->second.word_count);
+        }
+
+        for (const TermId term_id : search_server->GetSortedTermIds()) {
+            const PostingList& postings = search_server->postings_[term_id];
+            if (postings.GetDocumentCount() == 0) {
+                continue;
+            }
+            // Слово может остаться без документов, если все они исключены. Пустой список
+            // допустим в индексе: так же выглядит слово после RemoveDocument
+            const TermId merged_term_id = merged.InternTerm(search_server->term_pool_[term_id]);
+            PostingList& merged_postings = merged.postings_[merged_term_id];
+            for (std::size_t i = 0; i < postings.size(); ++i) {
+                const DocumentOrdinal merged_ordinal = merged_ordinals[postings.document_ordinals[i]];
+                if (merged_ordinal != removed) {
+                    merged_postings.Add(merged_ordinal, postings.term_freqs[i]);
+                    if (merged.has_positions_) {
+                        merged.positions_[merged_term_id].AppendEntry(search_server->positions_[term_id], i);
+                    }
+                }
+            }
+        }
+    }
+
+    // Прямой индекс соберется по спискам вхождений при первом обращении
+    merged.document_to_word_freqs_.Defer();
+    merged.OnDocumentsChanged();
+    return merged;
+}
+
+// IDF по суммарным колличествам документов всех серверов, формула та же, что и для одного сервера
+std::vector<double> SearchServer::ComputeInverseDocumentFreqs(const std::vector<const SearchServer*>& search_servers,
+    const Query& query, const std::set<int>& excluded_document_ids) {
+    int document_count = 0;
+    const std::size_t plus_word_count = query.plus_words.size();
+    std::vector<int> document_freqs(plus_word_count + query.plus_prefixes.size(), 0);
+    for (const SearchServer* search_server : search_servers) {
+        document_count += search_server->GetDocumentCount();
+        QueryBuffer query_buffer;
+        const QueryTermIds query_term_ids = search_server->ResolveQueryTerms(query, &query_buffer.resource);
+        for (std::size_t i = 0; i < plus_word_count; ++i) {
+            const PostingList* postings = search_server->FindPostings(query_term_ids.plus_term_ids[i]);
+            document_freqs[i] += postings == nullptr ? 0 : static_cast<int>(postings->GetDocumentCount());
+        }
+        // Документы серверов не пересекаются, поэтому размеры объединенных списков складываются
+        for (std::size_t i = 0; i < query.plus_prefixes.size(); ++i) {
+            std::vector<PostingList> prefix_postings;
+            prefix_postings.reserve(1);
+            const PostingList* postings = search_server->FindPrefixPostings(query.plus_prefixes[i], prefix_postings);
+            document_freqs[plus_word_count + i] += postings == nullptr ? 0 : static_cast<int>(postings->GetDocumentCount());
+        }
+    }
+
+    // Исключенные документы вычитаются из колличеств, их обычно немного
+    for (const int document_id : excluded_document_ids) {
+        for (const SearchServer* search_server : search_servers) {
+            if (!search_server->HasDocument(document_id)) {
+                continue;
+            }
+            --document_count;
+            const auto& word_freqs = search_server->GetWordFrequencies(document_id);
+            for (std::size_t i = 0; i < plus_word_count; ++i) {
+                document_freqs[i] -= static_cast<int>(word_freqs.count(query.plus_words[i]));
+            }
+            for (std::size_t i = 0; i < query.plus_prefixes.size(); ++i) {
+                const std::vector<TermId> term_ids = search_server->ExpandPrefix(query.plus_prefixes[i]);
+                document_freqs[plus_word_count + i] -= std::any_of(term_ids.begin(), term_ids.end(),
+                    [&](TermId term_id) { return word_freqs.count(search_server->term_pool_[term_id]) > 0; });
+            }
+        }
+    }
+
+    std::vector<double> inverse_document_freqs;
+    inverse_document_freqs.reserve(document_freqs.size());
+    for (const int document_freq : document_freqs) {
+        // Слово, которого нет ни в одном сервере, не найдет документов, значение IDF для него не важно
+        inverse_document_freqs.push_back(document_freq == 0 ? 0.0 : std::log(document_count * 1.0 / document_freq));
+    }
+    return inverse_document_freqs;
+}
+
+// Политика обновления закэшированных IDF
+void SearchServer::SetIdfRefreshPolicy(IdfRefreshPolicy policy) {
+    idf_refresh_policy_ = policy;
+    if (idf_refresh_policy_ == IdfRefreshPolicy::EAGER) {
+        RefreshInverseDocumentFreqs();
+    } else if (idf_refresh_policy_ == IdfRefreshPolicy::LAZY) {
+        // При EPOCH кэш мог отстать от индекса, поэтому значения пересчитываются заново по мере запросов
+        idf_cache_.Invalidate(postings_.size());
+    }
+}
+
+IdfRefreshPolicy SearchServer::GetIdfRefreshPolicy() const {
+    return idf_refresh_policy_;
+}
+
+// Способ вычисления топа документов
+void SearchServer::SetQueryEvaluation(QueryEvaluation evaluation) {
+    query_evaluation_ = evaluation;
+}
+
+void SearchServer::SetMaxPrefixExpansions(std::size_t max_expansions) {
+    max_prefix_expansions_ = max_expansions;
+    ++generation_;
+}
+
+std::size_t SearchServer::GetMaxPrefixExpansions() const {
+    return max_prefix_expansions_;
+}
+
+void SearchServer::SetRelevanceModel(RelevanceModel model) {
+    relevance_model_ = model;
+    ++generation_;
+}
+
+RelevanceModel SearchServer::GetRelevanceModel() const {
+    return relevance_model_;
+}
+
+void SearchServer::SetBm25Parameters(double k1, double b) {
+    // При отрицательных слагаемых знаменателя верхние оценки MaxScore были бы неверны
+    if (!(k1 >= 0.0) || !(b >= 0.0 && b <= 1.0)) {
+        throw std::invalid_argument("BM25 parameters must satisfy k1 >= 0 and 0 <= b <= 1");
+    }
+    bm25_k1_ = k1;
+    bm25_b_ = b;
+    ++generation_;
+}
+
+QueryEvaluation SearchServer::GetQueryEvaluation() const {
+    return query_evaluation_;
+}
+
+// Режим совпадения меняет выдачу, поэтому закэшированные результаты устаревают
+void SearchServer::SetQueryMatching(QueryMatching matching) {
+    query_matching_ = matching;
+    ++generation_;
+}
+
+QueryMatching SearchServer::GetQueryMatching() const {
+    return query_matching_;
+}
+
+// Пересчет IDF всех термов
+void SearchServer::RefreshInverseDocumentFreqs() {
+    ++generation_;
+    idf_cache_.Refresh(postings_.size(), [this](TermId term_id) {
+        return ComputeTermInverseDocumentFreq(term_id);
+    });
+}
+
 // Получение колличества документов в базе
 int SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
 
+// Поколение индекса
+std::uint64_t SearchServer::GetGeneration() const {
+    return generation_;
+}
+
+// Колличество документов, в которых встречается слово
+int SearchServer::GetDocumentFrequency(std::string_view word) const {
+    const PostingList* postings = FindPostings(term_ids_.Find(word));
+    return postings == nullptr ? 0 : static_cast<int>(postings->GetDocumentCount());
+}
+
+bool SearchServer::HasDocument(int document_id) const {
+    return documents_.count(document_id) > 0;
+}
+
+DocumentBitset SearchServer::GetDocumentOrdinals(const std::set<int>& document_ids) const {
+    DocumentBitset ordinals(ordinal_to_document_id_.size());
+    for (const int document_id : document_ids) {
+        const auto document_it = documents_.find(document_id);
+        if (document_it != documents_.end()) {
+            ordinals.Set(document_it->second.ordinal);
+        }
+    }
+    return ordinals;
+}
+
 // Получение ID доукента по его индексу
 int SearchServer::GetDocumentId(int index) const {
-    return document_ids_.at(index);
+    if (index < 0 || index >= static_cast<int>(documents_.size())) {
+        throw std::out_of_range("Document index is out of range");
+    }
+    // Пока удаленных номеров нет, индекс документа совпадает с его номером
+    if (!HasRemovedOrdinals()) {
+        return ordinal_to_document_id_[static_cast<std::size_t>(index)];
+    }
+    return ordinal_to_document_id_[removed_ordinals_.FindNthReset(static_cast<std::size_t>(index))];
+}
+
+// Итераторы по ID документов в порядке добавления
+SearchServer::DocumentIdIterator SearchServer::begin() const {
+    return DocumentIdIterator(this, 0);
+}
+
+SearchServer::DocumentIdIterator SearchServer::end() const {
+    return DocumentIdIterator(this, ordinal_to_document_id_.size());
+}
+
+SearchServer::DocumentIdIterator::DocumentIdIterator(const SearchServer* search_server, std::size_t ordinal)
+        : search_server_(search_server)
+        , ordinal_(ordinal) {
+    SkipRemoved();
+}
+
+SearchServer::DocumentIdIterator::reference SearchServer::DocumentIdIterator::operator*() const {
+    return search_server_->ordinal_to_document_id_[ordinal_];
+}
+
+SearchServer::DocumentIdIterator& SearchServer::DocumentIdIterator::operator++() {
+    ++ordinal_;
+    SkipRemoved();
+    return *this;
+}
+
+SearchServer::DocumentIdIterator SearchServer::DocumentIdIterator::operator++(int) {
+    DocumentIdIterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool SearchServer::DocumentIdIterator::operator==(const DocumentIdIterator& other) const {
+    return search_server_ == other.search_server_ && ordinal_ == other.ordinal_;
+}
+
+bool SearchServer::DocumentIdIterator::operator!=(const DocumentIdIterator& other) const {
+    return !(*this == other);
+}
+
+void SearchServer::DocumentIdIterator::SkipRemoved() {
+    if (!search_server_->HasRemovedOrdinals()) {
+        return;
+    }
+    while (ordinal_ < search_server_->ordinal_to_document_id_.size()
+        && search_server_->removed_ordinals_.Test(ordinal_)) {
+        ++ordinal_;
+    }
+}
+
+// Частоты слов документа, пустой словарь для отсутствующего документа
+const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    static const std::map<std::string_view, double> empty_word_freqs;
+
+    const ForwardIndex::Documents& forward_index = GetForwardIndex();
+    const auto it = forward_index.find(document_id);
+    return it == forward_index.end() ? empty_word_freqs : it->second;
 }
 
 // Поиск на совпадуние запросу
-std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string& raw_query,
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query,
                                                         int document_id) const {
-    Query query = ParseQuery(raw_query);
-    std::vector<std::string> matched_words;
-            
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+    return MatchDocument(std::execution::seq, raw_query, document_id);
+}
+
+// Проверка минус-префиксов и фраз, затем сбор найденных слов
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocumentTerms(const Query& query,
+    const QueryTermIds& query_term_ids, const DocumentData& document_data,
+    const std::vector<TermId>& matched_term_ids) const {
+    std::vector<std::string_view> matched_words;
+
+    for (const std::string_view prefix : query.minus_prefixes) {
+        for (const TermId term_id : ExpandPrefix(prefix)) {
+            if (postings_[term_id].Contains(document_data.ordinal)) {
+                return {matched_words, document_data.status};
+            }
         }
     }
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    // Документ, не содержащий фразу запроса, не совпадает с запросом, как и документ с минус-словом
+    if (!query.proximity_constraints.empty()) {
+        std::vector<DocumentOrdinal> ordinals{document_data.ordinal};
+        FilterProximityDocuments(query, query_term_ids, ordinals);
+        if (ordinals.empty()) {
+            return {matched_words, document_data.status};
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            break;
+    }
+    // Колличество плюс-слов и префиксов, найденных в документе
+    std::size_t matched_term_count = matched_term_ids.size();
+    for (const TermId term_id : matched_term_ids) {
+        matched_words.push_back(term_pool_[term_id]);
+    }
+    // Слова префиксов идут по алфавиту после плюс-слов и могут с ними совпадать
+    for (const std::string_view prefix : query.plus_prefixes) {
+        bool has_prefix = false;
+        for (const TermId term_id : ExpandPrefix(prefix)) {
+            if (postings_[term_id].Contains(document_data.ordinal)) {
+                matched_words.push_back(term_pool_[term_id]);
+                has_prefix = true;
+            }
         }
+        matched_term_count += has_prefix ? 1 : 0;
     }
-    return {matched_words, documents_.at(document_id).status};
+    // При ALL_TERMS документ без какого-то из слов запроса не совпадает с запросом
+    if (query_matching_ == QueryMatching::ALL_TERMS
+        && matched_term_count < query.plus_words.size() + query.plus_prefixes.size()) {
+        matched_words.clear();
+        return {matched_words, document_data.status};
+    }
+    if (!query.plus_prefixes.empty()) {
+        std::sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    }
+    return {matched_words, document_data.status};
 }
 
 // Проверка слова, является ли оно стоп-словом
-bool SearchServer::IsStopWord(const std::string& word) const {
+bool SearchServer::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string> words;
-    for (const std::string& word : SplitIntoWords(text)) {
+// Терм словаря для слова, новое слово сохраняется в term_pool_ и получает пустой список вхождений
+TermId SearchServer::InternTerm(std::string_view word) {
+    TermId term_id = term_ids_.Find(word);
+    if (term_id == NO_TERM_ID) {
+        term_id = static_cast<TermId>(postings_.size());
+        term_ids_.Emplace(term_pool_.emplace_back(word), term_id);
+        postings_.emplace_back();
+        if (has_positions_) {
+            positions_.emplace_back();
+        }
+    }
+    return term_id;
+}
+
+// ID термов по возрастанию слов, нужны снимку и слиянию, которые пишут термы по порядку
+std::vector<TermId> SearchServer::GetSortedTermIds() const {
+    std::vector<TermId> term_ids(term_pool_.size());
+    std::iota(term_ids.begin(), term_ids.end(), 0);
+    std::sort(term_ids.begin(), term_ids.end(), [this](TermId lhs, TermId rhs) {
+        return term_pool_[lhs] < term_pool_[rhs];
+    });
+    return term_ids;
+}
+
+// Проверка ID пакета до разбора: ID неотрицательны, новы и не повторяются
+void SearchServer::CheckBatchDocumentIds(const std::vector<DocumentToAdd>& documents) const {
+    std::vector<int> document_ids;
+    document_ids.reserve(documents.size());
+    for (const DocumentToAdd& document : documents) {
+        if (document.id < 0 || documents_.count(document.id)) {
+            throw std::invalid_argument("Document ID is wrong or a document with this ID has already been added earlier");
+        }
+        document_ids.push_back(document.id);
+    }
+    std::sort(document_ids.begin(), document_ids.end());
+    if (std::adjacent_find(document_ids.begin(), document_ids.end()) != document_ids.end()) {
+        throw std::invalid_argument("Document ID is wrong or a document with this ID has already been added earlier");
+    }
+}
+
+// Разбор документов части пакета. Частоты считаются так же, как в AddDocument: повторным
+// прибавлением 1 / колличество слов, поэтому значения совпадают побитово
+void SearchServer::ParseDocumentBatchChunk(const std::vector<DocumentToAdd>& documents,
+    DocumentBatchChunk& chunk) const {
+    std::unordered_map<std::string_view, TermId> local_term_ids;
+    std::vector<std::string_view> words;
+    // Слово и его позиция без стоп-слов: после сортировки позиции каждого слова идут по возрастанию
+    std::vector<std::pair<std::string_view, std::uint32_t>> word_positions;
+    chunk.document_term_offsets.push_back(0);
+
+    for (std::size_t index = chunk.begin; index < chunk.end; ++index) {
+        words = SplitIntoWordsNoStop(documents[index].text);
+        if (!std::all_of(words.begin(), words.end(), IsValidWord)) {
+            chunk.is_valid = false;
+            return;
+        }
+        const double inv_word_count = 1.0 / static_cast<double>(words.size());
+        chunk.document_word_counts.push_back(static_cast<std::uint32_t>(words.size()));
+        word_positions.clear();
+        for (std::uint32_t position = 0; position < words.size(); ++position) {
+            word_positions.push_back({words[position], position});
+        }
+        std::sort(word_positions.begin(), word_positions.end());
+        for (auto it = word_positions.begin(); it != word_positions.end();) {
+            double term_freq = 0;
+            const auto word_end = std::find_if(it, word_positions.end(),
+                [it](const auto& word_position) { return word_position.first != it->first; });
+            for (auto word = it; word != word_end; ++word) {
+                term_freq += inv_word_count;
+            }
+
+            const auto [term_it, is_new] = local_term_ids.emplace(it->first, static_cast<TermId>(chunk.words.size()));
+            if (is_new) {
+                chunk.words.push_back(it->first);
+                chunk.postings.emplace_back();
+                if (has_positions_) {
+                    chunk.positions.emplace_back();
+                }
+            }
+            chunk.postings[term_it->second].Add(static_cast<DocumentOrdinal>(index), term_freq);
+            if (has_positions_) {
+                for (auto word = it; word != word_end; ++word) {
+                    chunk.positions[term_it->second].Add(word == it, word->second);
+                }
+            }
+            chunk.document_terms.push_back({term_it->second, term_freq});
+            it = word_end;
+        }
+        chunk.document_term_offsets.push_back(chunk.document_terms.size());
+    }
+}
+
+// Слияние разобранных частей в индекс
+void SearchServer::MergeDocumentBatch(const std::vector<DocumentToAdd>& documents,
+    const std::vector<DocumentBatchChunk>& chunks) {
+    const auto first_ordinal = static_cast<DocumentOrdinal>(ordinal_to_document_id_.size());
+
+    std::vector<std::uint32_t> word_counts(documents.size());
+    for (const DocumentBatchChunk& chunk : chunks) {
+        std::copy(chunk.document_word_counts.begin(), chunk.document_word_counts.end(),
+            word_counts.begin() + static_cast<std::ptrdiff_t>(chunk.begin));
+    }
+    for (std::size_t index = 0; index < documents.size(); ++index) {
+        const DocumentToAdd& document = documents[index];
+        const int rating = ComputeAverageRating(document.ratings);
+        documents_.emplace(document.id, DocumentData{rating, document.status,
+            static_cast<DocumentOrdinal>(first_ordinal + index), word_counts[index]});
+        AppendOrdinal(document.id, document.status, rating, word_counts[index]);
+    }
+
+    std::vector<TermId> terms;
+    for (const DocumentBatchChunk& chunk : chunks) {
+        terms.clear();
+        for (std::size_t local_term_id = 0; local_term_id < chunk.words.size(); ++local_term_id) {
+            terms.push_back(InternTerm(chunk.words[local_term_id]));
+            const PostingList& chunk_postings = chunk.postings[local_term_id];
+            PostingList& postings = postings_[terms.back()];
+            for (std::size_t i = 0; i < chunk_postings.size(); ++i) {
+                postings.Add(first_ordinal + chunk_postings.document_ordinals[i], chunk_postings.term_freqs[i]);
+                if (has_positions_) {
+                    positions_[terms.back()].AppendEntry(chunk.positions[local_term_id], i);
+                }
+            }
+        }
+
+        // Слова документа уже отсортированы, поэтому прямой индекс заполняется вставкой в конец.
+        // Отложенный прямой индекс соберется по спискам вхождений вместе с документами пакета
+        if (!document_to_word_freqs_.IsBuilt()) {
+            continue;
+        }
+        ForwardIndex::Documents& forward_index = GetForwardIndex();
+        for (std::size_t index = chunk.begin; index < chunk.end; ++index) {
+            auto& word_freqs = forward_index[documents[index].id];
+            const std::size_t offset = index - chunk.begin;
+            for (std::size_t i = chunk.document_term_offsets[offset]; i < chunk.document_term_offsets[offset + 1]; ++i) {
+                const auto& [local_term_id, term_freq] = chunk.document_terms[i];
+                word_freqs.emplace_hint(word_freqs.end(), term_pool_[terms[local_term_id]], term_freq);
+            }
+        }
+    }
+    OnDocumentsChanged();
+}
+
+// Прямой индекс, отложенный после загрузки снимка или объединения собирается при первом обращении
+ForwardIndex::Documents& SearchServer::GetForwardIndex() {
+    return document_to_word_freqs_.Get([this](ForwardIndex::Documents& documents) {
+        FillForwardIndex(documents);
+    });
+}
+
+const ForwardIndex::Documents& SearchServer::GetForwardIndex() const {
+    return document_to_word_freqs_.Get([this](ForwardIndex::Documents& documents) {
+        FillForwardIndex(documents);
+    });
+}
+
+// Сборка прямого индекса по спискам вхождений. Термы обходятся по возрастанию,
+// поэтому в словарь документа слова добавляются в конец
+void SearchServer::FillForwardIndex(ForwardIndex::Documents& documents) const {
+    std::vector<ForwardIndex::WordFreqs*> ordinal_word_freqs(ordinal_to_document_id_.size(), nullptr);
+    for (const auto& [document_id, document_data] : documents_) {
+        ordinal_word_freqs[document_data.ordinal] = &documents.emplace_hint(documents.end(), document_id,
+            ForwardIndex::WordFreqs{})->second;
+    }
+    for (const TermId term_id : GetSortedTermIds()) {
+        const PostingList& postings = postings_[term_id];
+        for (std::size_t i = 0; i < postings.size(); ++i) {
+            if (postings.IsRemoved(i)) {
+                continue;
+            }
+            auto& word_freqs = *ordinal_word_freqs[postings.document_ordinals[i]];
+            word_freqs.emplace_hint(word_freqs.end(), term_pool_[term_id], postings.term_freqs[i]);
+        }
+    }
+}
+
+// Выдача следующего порядкового номера документу
+void SearchServer::AppendOrdinal(int document_id, DocumentStatus status, int rating, std::uint32_t word_count) {
+    ordinal_to_document_id_.push_back(document_id);
+    removed_ordinals_.Resize(ordinal_to_document_id_.size());
+    ordinal_statuses_.push_back(status);
+    ordinal_ratings_.push_back(rating);
+    // У документа из одних стоп-слов нет вхождений, его норма не читается
+    ordinal_length_norms_.push_back(word_count == 0 ? 0.0 : 1.0 / word_count);
+    total_word_count_ += word_count;
+}
+
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+    std::vector<std::string_view> words;
+    for (const std::string_view word : SplitIntoWords(text)) {
         if (!IsStopWord(word)) {
             words.push_back(word);
         }
@@ -97,50 +843,354 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 }
 
 // Парсинг запроса
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
-    bool is_minus = false;
-    
-    if(!IsValidWord(text)){
-        throw std::invalid_argument("The request has invalid characters");
+Query SearchServer::ParseQuery(std::string_view text, std::pmr::memory_resource* resource) const {
+    return ::ParseQuery(text, stop_words_, resource);
+}
+
+SearchServer::QueryTermIds::QueryTermIds(std::pmr::memory_resource* resource)
+    : plus_term_ids(resource)
+    , minus_term_ids(resource)
+    , proximity_term_ids(resource) {
+}
+
+// Перевод слов запроса в ID термов: каждое слово ищется в словаре один раз
+SearchServer::QueryTermIds SearchServer::ResolveQueryTerms(const Query& query,
+    std::pmr::memory_resource* resource) const {
+    QueryTermIds query_term_ids(resource);
+    query_term_ids.plus_term_ids.reserve(query.plus_words.size());
+    for (const std::string_view word : query.plus_words) {
+        query_term_ids.plus_term_ids.push_back(term_ids_.Find(word));
+    }
+    query_term_ids.minus_term_ids.reserve(query.minus_words.size());
+    for (const std::string_view word : query.minus_words) {
+        query_term_ids.minus_term_ids.push_back(term_ids_.Find(word));
+    }
+    query_term_ids.proximity_term_ids.reserve(query.proximity_words.size());
+    for (const std::string_view word : query.proximity_words) {
+        query_term_ids.proximity_term_ids.push_back(term_ids_.Find(word));
     }
+    return query_term_ids;
+}
+
+// Плюс-слова и плюс-префиксы запроса, найденные в индексе, вместе с их IDF
+std::vector<std::pair<const PostingList*, double>> SearchServer::GetPlusWordPostings(const Query& query,
+    const QueryTermIds& query_term_ids, std::vector<PostingList>& prefix_postings) const {
+    std::vector<std::pair<const PostingList*, double>> postings;
 
-    if(!IsValidWord(text) || (text[0] == '-' && text.size() == 1) || (text[0] == '-' && text[1] == '-')){
-        throw std::invalid_argument("The query has extra characters before or after the word");
+    // Пересчитываются только устаревшие IDF слов этого запроса, а не всего словаря
+    if (idf_refresh_policy_ == IdfRefreshPolicy::LAZY) {
+        idf_cache_.RefreshIfStale(query_term_ids.plus_term_ids, [this](TermId term_id) {
+            return ComputeTermInverseDocumentFreq(term_id);
+        });
     }
 
-    if (text[0] == '-') {
-        is_minus = true;
-        text = text.substr(1);
+    for (const TermId term_id : query_term_ids.plus_term_ids) {
+        const PostingList* word_postings = FindPostings(term_id);
+        if (word_postings != nullptr) {
+            postings.push_back({word_postings, GetInverseDocumentFreq(term_id)});
+        }
     }
-    return {text, is_minus, IsStopWord(text)};
+
+    // Объединенные списки не перемещаются, пока на них ссылаются найденные списки
+    prefix_postings.reserve(query.plus_prefixes.size());
+    for (const std::string_view prefix : query.plus_prefixes) {
+        const PostingList* word_postings = FindPrefixPostings(prefix, prefix_postings);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        // Префикс с одним словом ищется как это слово, объединение - как слово со своим IDF
+        const bool is_single_word = prefix_postings.empty() || word_postings != &prefix_postings.back();
+        postings.push_back({word_postings, is_single_word
+            ? GetInverseDocumentFreq(static_cast<TermId>(word_postings - postings_.data()))
+            : ComputeWordInverseDocumentFreq(*word_postings)});
+    }
+    return postings;
 }
 
-// Парсинг запроса
-SearchServer::Query SearchServer::ParseQuery(const std::string& text) const {
-    Query query;
-        
-    for (const std::string& word : SplitIntoWords(text)) {
-        QueryWord query_word = ParseQueryWord(word);
+// Минус-слова запроса, найденные в индексе
+std::vector<const PostingList*> SearchServer::GetMinusWordPostings(const Query& query,
+    const QueryTermIds& query_term_ids) const {
+    std::vector<const PostingList*> postings;
 
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
-            } else {
-                query.plus_words.insert(query_word.data);
+    for (const TermId term_id : query_term_ids.minus_term_ids) {
+        const PostingList* word_postings = FindPostings(term_id);
+        if (word_postings != nullptr) {
+            postings.push_back(word_postings);
+        }
+    }
+    // Для исключения документов объединять списки слов префикса не нужно
+    for (const std::string_view prefix : query.minus_prefixes) {
+        for (const TermId term_id : ExpandPrefix(prefix)) {
+            postings.push_back(&postings_[term_id]);
+        }
+    }
+    return postings;
+}
+
+// Слова с префиксом по словарю с фронтальным кодированием
+std::vector<TermId> SearchServer::ExpandPrefix(std::string_view prefix) const {
+    std::vector<TermId> term_ids;
+    if (max_prefix_expansions_ == 0) {
+        return term_ids;
+    }
+    term_dictionary_.RefreshIfStale(term_pool_);
+    term_dictionary_.ForEachTermWithPrefix(prefix, [&](TermId term_id) {
+        // Слово, у которого не осталось документов, предел не расходует
+        if (postings_[term_id].GetDocumentCount() > 0) {
+            term_ids.push_back(term_id);
+        }
+        return term_ids.size() < max_prefix_expansions_;
+    });
+    return term_ids;
+}
+
+// Объединение списков вхождений слов префикса k-путевым слиянием
+const PostingList* SearchServer::FindPrefixPostings(std::string_view prefix,
+    std::vector<PostingList>& prefix_postings) const {
+    const std::vector<TermId> term_ids = ExpandPrefix(prefix);
+    if (term_ids.empty()) {
+        return nullptr;
+    }
+    if (term_ids.size() == 1) {
+        return &postings_[term_ids.front()];
+    }
+
+    // Номер документа и индекс слова в term_ids: при равных номерах первым выходит слово,
+    // раньше идущее по алфавиту, поэтому частоты складываются в одном и том же порядке
+    using Cursor = std::pair<DocumentOrdinal, std::size_t>;
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> cursors;
+    std::vector<std::size_t> positions(term_ids.size(), 0);
+    std::size_t entry_count = 0;
+    for (std::size_t word = 0; word < term_ids.size(); ++word) {
+        const PostingList& postings = postings_[term_ids[word]];
+        cursors.push({postings.document_ordinals.front(), word});
+        entry_count += postings.size();
+    }
+
+    PostingList& union_postings = prefix_postings.emplace_back();
+    union_postings.document_ordinals.reserve(entry_count);
+    union_postings.term_freqs.reserve(entry_count);
+    while (!cursors.empty()) {
+        const auto [ordinal, word] = cursors.top();
+        cursors.pop();
+        const PostingList& postings = postings_[term_ids[word]];
+        if (!postings.IsRemoved(positions[word])) {
+            union_postings.Add(ordinal, postings.term_freqs[positions[word]]);
+        }
+        if (++positions[word] < postings.size()) {
+            cursors.push({postings.document_ordinals[positions[word]], word});
+        }
+    }
+    return &union_postings;
+}
+
+// Отметка документов с минус-словами
+bool SearchServer::MarkExcludedDocuments(const std::vector<const PostingList*>& minus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, DocumentBitset& excluded) {
+    if (minus_postings.empty()) {
+        return false;
+    }
+    excluded.Resize(upper - lower);
+    excluded.Clear();
+    for (const PostingList* postings : minus_postings) {
+        for (std::size_t i = postings->LowerBound(lower);
+            i < postings->size() && postings->document_ordinals[i] < upper; ++i) {
+            excluded.Set(postings->document_ordinals[i] - lower);
+        }
+    }
+    return true;
+}
+
+// Сброс в маске документов, не входящих в набор ID
+void SearchServer::RestrictDocumentMask(const IdSet& document_filter, DocumentOrdinal lower, DocumentOrdinal upper,
+    std::uint8_t* mask) const {
+    static thread_local std::vector<std::uint8_t> in_set;
+    in_set.assign(upper - lower, 0);
+    for (const int document_id : document_filter.GetDocumentIds()) {
+        const auto it = documents_.find(document_id);
+        if (it != documents_.end() && lower <= it->second.ordinal && it->second.ordinal < upper) {
+            in_set[it->second.ordinal - lower] = 1;
+        }
+    }
+    for (std::size_t i = 0; i < upper - lower; ++i) {
+        mask[i] &= in_set[i];
+    }
+}
+
+// ID документов, удовлетворяющих ограничениям близости. Кандидаты - документы самого редкого
+// слова первого ограничения, остальные списки только проверяются для них
+std::vector<int> SearchServer::FindProximityDocumentIds(const Query& query,
+    const QueryTermIds& query_term_ids) const {
+    if (!has_positions_) {
+        throw std::invalid_argument("Phrase and NEAR queries require positions to be enabled");
+    }
+    const ProximityConstraint& constraint = query.proximity_constraints.front();
+    const PostingList* rarest_postings = nullptr;
+    for (std::size_t i = constraint.word_begin; i < constraint.word_end; ++i) {
+        const PostingList* postings = FindPostings(query_term_ids.proximity_term_ids[i]);
+        if (postings == nullptr) {
+            return {};
+        }
+        if (rarest_postings == nullptr || postings->size() < rarest_postings->size()) {
+            rarest_postings = postings;
+        }
+    }
+
+    // Удаленный документ мог уступить свой ID новому, поэтому его номер не должен попасть в кандидаты
+    std::vector<DocumentOrdinal> ordinals;
+    ordinals.reserve(rarest_postings->GetDocumentCount());
+    for (std::size_t i = 0; i < rarest_postings->size(); ++i) {
+        if (!rarest_postings->IsRemoved(i)) {
+            ordinals.push_back(rarest_postings->document_ordinals[i]);
+        }
+    }
+    FilterProximityDocuments(query, query_term_ids, ordinals);
+
+    std::vector<int> document_ids;
+    document_ids.reserve(ordinals.size());
+    for (const DocumentOrdinal ordinal : ordinals) {
+        document_ids.push_back(ordinal_to_document_id_[ordinal]);
+    }
+    return document_ids;
+}
+
+// Отбор документов, удовлетворяющих ограничениям близости
+void SearchServer::FilterProximityDocuments(const Query& query, const QueryTermIds& query_term_ids,
+    std::vector<DocumentOrdinal>& ordinals) const {
+    if (!has_positions_) {
+        throw std::invalid_argument("Phrase and NEAR queries require positions to be enabled");
+    }
+    // Буферы позиций переиспользуются между запросами одного потока
+    static thread_local std::vector<std::vector<std::uint32_t>> word_positions;
+
+    for (const ProximityConstraint& constraint : query.proximity_constraints) {
+        const std::size_t word_count = constraint.word_end - constraint.word_begin;
+        const TermId* word_term_ids = query_term_ids.proximity_term_ids.data() + constraint.word_begin;
+        for (std::size_t word = 0; word < word_count; ++word) {
+            if (FindPostings(word_term_ids[word]) == nullptr) {
+                ordinals.clear();
+                return;
             }
         }
+        if (word_positions.size() < word_count) {
+            word_positions.resize(word_count);
+        }
+
+        // Кандидаты идут по возрастанию, поэтому поиск в каждом списке продолжается с прошлого места
+        std::vector<std::size_t> cursors(word_count, 0);
+        std::size_t kept = 0;
+        for (const DocumentOrdinal ordinal : ordinals) {
+            bool has_all_words = true;
+            for (std::size_t word = 0; word < word_count && has_all_words; ++word) {
+                const PostingList& postings = postings_[word_term_ids[word]];
+                cursors[word] = postings.LowerBound(ordinal, cursors[word]);
+                has_all_words = cursors[word] < postings.size() && postings.document_ordinals[cursors[word]] == ordinal;
+            }
+            if (!has_all_words) {
+                continue;
+            }
+            for (std::size_t word = 0; word < word_count; ++word) {
+                positions_[word_term_ids[word]].Decode(cursors[word], word_positions[word]);
+            }
+            const bool matches = constraint.is_phrase
+                ? HasPhrase(word_positions, word_count)
+                : HasNearPair(word_positions[0], word_positions[1], constraint.max_distance,
+                    word_term_ids[0] == word_term_ids[1]);
+            if (matches) {
+                ordinals[kept++] = ordinal;
+            }
+        }
+        ordinals.resize(kept);
     }
-    return query;
 }
 
-// Проверка слова на валидность
-bool SearchServer::IsValidWord(const std::string& word) {
-    return none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-        });
+// Номера документов плотные: удалено не больше половины выданных номеров
+bool SearchServer::HasDenseOrdinals() const {
+    return ordinal_to_document_id_.size() <= 2 * documents_.size();
+}
+
+bool SearchServer::HasRemovedOrdinals() const {
+    return ordinal_to_document_id_.size() != documents_.size();
+}
+
+void SearchServer::CompactOrdinals() {
+    const DocumentOrdinal removed = std::numeric_limits<DocumentOrdinal>::max();
+    std::vector<DocumentOrdinal> compacted_ordinals(ordinal_to_document_id_.size(), removed);
+    DocumentOrdinal compacted_count = 0;
+    for (DocumentOrdinal ordinal = 0; ordinal < compacted_ordinals.size(); ++ordinal) {
+        if (removed_ordinals_.Test(ordinal)) {
+            continue;
+        }
+        compacted_ordinals[ordinal] = compacted_count;
+        ordinal_to_document_id_[compacted_count] = ordinal_to_document_id_[ordinal];
+        ordinal_statuses_[compacted_count] = ordinal_statuses_[ordinal];
+        ordinal_ratings_[compacted_count] = ordinal_ratings_[ordinal];
+        ordinal_length_norms_[compacted_count] = ordinal_length_norms_[ordinal];
+        ++compacted_count;
+    }
+    ordinal_to_document_id_.resize(compacted_count);
+    ordinal_to_document_id_.shrink_to_fit();
+    ordinal_statuses_.resize(compacted_count);
+    ordinal_statuses_.shrink_to_fit();
+    ordinal_ratings_.resize(compacted_count);
+    ordinal_ratings_.shrink_to_fit();
+    ordinal_length_norms_.resize(compacted_count);
+    ordinal_length_norms_.shrink_to_fit();
+    removed_ordinals_ = DocumentBitset(compacted_count);
+
+    for (auto& [document_id, document_data] : documents_) {
+        document_data.ordinal = compacted_ordinals[document_data.ordinal];
+    }
+
+    for (TermId term_id = 0; term_id < postings_.size(); ++term_id) {
+        PostingList& postings = postings_[term_id];
+        // Все вхождения удаленных документов помечены, после уплотнения в списке только живые номера
+        if (postings.removed_count > 0) {
+            if (has_positions_) {
+                positions_[term_id].RemoveEntries(postings);
+            }
+            postings.Compact();
+        }
+        for (DocumentOrdinal& ordinal : postings.document_ordinals) {
+            ordinal = compacted_ordinals[ordinal];
+        }
+    }
+}
+
+// Список вхождений терма или nullptr, если слова нет в индексе
+const PostingList* SearchServer::FindPostings(TermId term_id) const {
+    // После удаления документов список вхождений слова может опустеть
+    if (term_id == NO_TERM_ID || postings_[term_id].GetDocumentCount() == 0) {
+        return nullptr;
+    }
+    return &postings_[term_id];
 }
 
 // Подсчет IDF
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string& word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeWordInverseDocumentFreq(const PostingList& postings) const {
+    return std::log(GetDocumentCount() * 1.0 / static_cast<double>(postings.GetDocumentCount()));
+}
+
+// IDF терма для кэша, NaN для терма, который сейчас не встречается ни в одном документе
+double SearchServer::ComputeTermInverseDocumentFreq(TermId term_id) const {
+    const PostingList& postings = postings_[term_id];
+    return postings.GetDocumentCount() == 0 ? std::nan("") : ComputeWordInverseDocumentFreq(postings);
+}
+
+// IDF терма из кэша, для термов без закэшированного значения - подсчет на месте
+double SearchServer::GetInverseDocumentFreq(TermId term_id) const {
+    const std::optional<double> cached = idf_cache_.Get(term_id);
+    return cached ? *cached : ComputeWordInverseDocumentFreq(postings_[term_id]);
+}
+
+// Обновление кэша IDF после изменения набора документов
+void SearchServer::OnDocumentsChanged() {
+    ++generation_;
+    if (idf_refresh_policy_ == IdfRefreshPolicy::EPOCH) {
+        return;
+    }
+    idf_cache_.Invalidate(postings_.size());
+    if (idf_refresh_policy_ == IdfRefreshPolicy::EAGER) {
+        RefreshInverseDocumentFreqs();
+    }
 }
\ No newline at end of file
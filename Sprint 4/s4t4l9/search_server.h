@@ -1,17 +1,82 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <execution>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <numeric>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "document.h"
+#include "document_bitset.h"
+#include "document_predicates.h"
+#include "forward_index.h"
+#include "idf_cache.h"
+#include "position_list.h"
+#include "posting_intersection.h"
+#include "posting_list.h"
+#include "query.h"
+#include "relevance_accumulator.h"
+#include "relevance_scorers.h"
 #include "string_processing.h"
+#include "term_dictionary.h"
+#include "term_hash_map.h"
+#include "top_documents.h"
 
+// Колличество документов в выдаче по умолчанию
+const std::size_t MAX_RESULT_DOCUMENT_COUNT = 5;
+
+// Колличество слов, в которое по умолчанию раскрывается префикс запроса
+const std::size_t MAX_PREFIX_EXPANSIONS = 64;
+
+// Размер окна номеров документов, в котором MaxScore накапливает вклады основных слов. Кратен 64
+const std::size_t MAX_SCORE_WINDOW_SIZE = 4096;
+
+// Способ вычисления топа документов, результаты обоих способов совпадают
+enum class QueryEvaluation {
+    // Релевантность считается для каждого документа с плюс-словами
+    EXHAUSTIVE,
+    // Документы обходятся по возрастанию номера, документы, которые по верхним оценкам
+    // термов не могут попасть в топ, пропускаются (MaxScore)
+    MAX_SCORE,
+};
+
+// Какие документы считаются найденными по плюс-словам запроса
+enum class QueryMatching {
+    // Документы хотя бы с одним плюс-словом
+    ANY_TERM,
+    // Документы со всеми плюс-словами, префикс считается одним словом
+    ALL_TERMS,
+};
+
+// Ограничение шаблонных перегрузок политиками выполнения из <execution>
+template <typename ExecutionPolicy>
+using EnableIfExecutionPolicy = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>, bool>;
+
+// Политика для циклов сервера: seq выполняется последовательно, par и par_unseq - как par.
+// Тела циклов выделяют память и берут мьютексы, поэтому векторизованное выполнение им не подходит
+template <typename ExecutionPolicy>
+const auto& GetLoopPolicy(const ExecutionPolicy&) {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        return std::execution::seq;
+    } else {
+        return std::execution::par;
+    }
+}
 
 class SearchServer {
     
@@ -20,86 +85,520 @@ class SearchServer {
         // Объявление конструктора класса SearchServer
         explicit SearchServer(const std::string& stop_words_text);
 
+        explicit SearchServer(std::string_view stop_words_text);
+
         // Объявление шаблонного конструктора класса SearchServer
         template <typename StringContainer>
         explicit SearchServer(const StringContainer& stop_words);
 
+        // Ключи словаря term_ids_ и прямого индекса document_to_word_freqs_ ссылаются на строки term_pool_,
+        // поэтому копия указывала бы на строки оригинала. При перемещении deque передает свои блоки
+        // целиком, строки остаются на месте и ссылки на них не портятся
+        SearchServer(const SearchServer&) = delete;
+
+        SearchServer& operator=(const SearchServer&) = delete;
+
+        SearchServer(SearchServer&&) = default;
+
+        // Включение позиционного индекса для фраз и NEAR/k. Позиции занимают память на каждое
+        // вхождение слова, поэтому по умолчанию не хранятся. Вызывается до добавления документов
+        void EnablePositions();
+
+        bool HasPositions() const;
+
+        // Сохранение индекса в бинарный снимок. Позиции в снимок не попадают
+        void SaveSnapshot(const std::string& path) const;
+
+        // Загрузка индекса из снимка без повторного разбора текстов документов
+        static SearchServer LoadSnapshot(const std::string& path);
+
+        // Объединение серверов с непересекающимися ID документов. Документы нумеруются
+        // в порядке серверов, поэтому списки вхождений склеиваются без сортировки.
+        // Документы из excluded_document_ids в результат не попадают. Позиции переносятся,
+        // если они есть у всех серверов
+        static SearchServer Merge(const std::vector<const SearchServer*>& search_servers,
+            const std::set<int>& excluded_document_ids = {});
+
+        // IDF плюс-слов, затем плюс-префиксов запроса так, как если бы документы всех серверов,
+        // кроме excluded_document_ids, лежали в одном индексе. Префикс раскрывается каждым сервером
+        // по своему словарю, поэтому при срабатывании предела раскрытия слова серверов могут различаться
+        static std::vector<double> ComputeInverseDocumentFreqs(const std::vector<const SearchServer*>& search_servers,
+            const Query& query, const std::set<int>& excluded_document_ids = {});
+
         // Функция добавления документов
-        void AddDocument(int document_id, const std::string& document, DocumentStatus status,
+        void AddDocument(int document_id, std::string_view document, DocumentStatus status,
             const std::vector<int>& ratings);
 
+        // Пакетное добавление: документы разбираются параллельно, а их вхождения сливаются
+        // в списки за один упорядоченный проход. Пакет добавляется целиком или не добавляется вовсе
+        void AddDocuments(const std::vector<DocumentToAdd>& documents);
+
+        // Пакетное добавление с политикой выполнения (std::execution::seq / par / par_unseq)
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        void AddDocuments(ExecutionPolicy&& policy, const std::vector<DocumentToAdd>& documents);
+
         // Объявление аблонной функции поиска топа документов с функцией предикатом
         template <typename DocumentPredicate>
-        std::vector<Document> FindTopDocuments(const std::string& raw_query,
-            DocumentPredicate document_predicate) const;
+        std::vector<Document> FindTopDocuments(std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
         // Переопределение функции поиска топа документов с заданным статусом документов
-        std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const;
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+            std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
         // Переопределение функции поиска топа документов 
-        std::vector<Document> FindTopDocuments(const std::string& raw_query) const;
+        std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+        // Поиск топа документов с политикой выполнения (std::execution::seq / par / par_unseq)
+        template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        // Поиск топа документов в переданный отборщик, например в участок общего буфера результатов
+        template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        void FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+            DocumentPredicate document_predicate, TopDocuments& top_documents) const;
+
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+            DocumentStatus status, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+        // Поиск по разобранному запросу с IDF плюс-слов, посчитанными снаружи (по порядку query.plus_words,
+        // затем query.plus_prefixes). Нужен, когда индекс разбит на несколько серверов и IDF считается по всем сразу.
+        // Документы с номерами из excluded_ordinals (см. GetDocumentOrdinals) в результат не попадают
+        template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        void CollectTopDocuments(ExecutionPolicy&& policy, const Query& query,
+            const std::vector<double>& inverse_document_freqs, DocumentPredicate document_predicate,
+            TopDocuments& top_documents, const DocumentBitset* excluded_ordinals = nullptr) const;
+
+        // Номера документов из document_ids, которые есть на сервере. Строится один раз
+        // и проверяется в CollectTopDocuments за O(1) на документ вместо поиска ID в наборе
+        DocumentBitset GetDocumentOrdinals(const std::set<int>& document_ids) const;
+
+        // Удаление документа, затрагивает только списки вхождений слов этого документа
+        void RemoveDocument(int document_id);
+
+        // Удаление документа с политикой выполнения (std::execution::seq / par / par_unseq)
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        void RemoveDocument(ExecutionPolicy&& policy, int document_id);
+
+        // Политика обновления закэшированных IDF, по умолчанию LAZY
+        void SetIdfRefreshPolicy(IdfRefreshPolicy policy);
+
+        IdfRefreshPolicy GetIdfRefreshPolicy() const;
+
+        // Способ вычисления топа, по умолчанию EXHAUSTIVE. MAX_SCORE выгоден для длинных запросов
+        // с небольшим max_count, когда большинство найденных документов заведомо не попадает в топ
+        void SetQueryEvaluation(QueryEvaluation evaluation);
+
+        QueryEvaluation GetQueryEvaluation() const;
+
+        // Режим совпадения, по умолчанию ANY_TERM. При ALL_TERMS списки вхождений пересекаются
+        // от самого короткого, релевантность считается только для документов пересечения
+        void SetQueryMatching(QueryMatching matching);
+
+        QueryMatching GetQueryMatching() const;
+
+        // Префикс cat* раскрывается в первые по алфавиту max_expansions слов индекса с этим префиксом,
+        // чтобы короткий префикс вроде a* не обходил списки вхождений половины словаря
+        void SetMaxPrefixExpansions(std::size_t max_expansions);
+
+        std::size_t GetMaxPrefixExpansions() const;
+
+        // Модель релевантности, по умолчанию TF_IDF
+        void SetRelevanceModel(RelevanceModel model);
+
+        RelevanceModel GetRelevanceModel() const;
+
+        // Параметры BM25: k1 >= 0 задает насыщение по частоте слова, b из [0, 1] - вес нормы длины документа
+        void SetBm25Parameters(double k1, double b);
+
+        // Пересчет IDF всех термов. При политике EPOCH вызывается в конце пакета добавлений,
+        // до этого запросы используют значения предыдущего пересчета
+        void RefreshInverseDocumentFreqs();
 
         // Получение колличества документов в базе
         int GetDocumentCount() const;
 
-        // Получение ID доукента по его индексу
+        // Поколение индекса: увеличивается при каждом изменении, которое может поменять выдачу
+        // (добавление и удаление документов, пересчет IDF, предел раскрытия префиксов, модель релевантности,
+        // режим совпадения)
+        std::uint64_t GetGeneration() const;
+
+        // Парсинг запроса, память под слова берется из resource
+        Query ParseQuery(std::string_view text,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+        // Колличество документов, в которых встречается слово
+        int GetDocumentFrequency(std::string_view word) const;
+
+        bool HasDocument(int document_id) const;
+
+        // Получение ID доукента по его индексу в порядке добавления
         int GetDocumentId(int index) const;
+
+        // Итератор по ID документов в порядке добавления. Номера документов выдаются по порядку добавления,
+        // поэтому ID обходятся по номерам с пропуском удаленных
+        class DocumentIdIterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = int;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const int*;
+                using reference = const int&;
+
+                DocumentIdIterator() = default;
+
+                reference operator*() const;
+
+                DocumentIdIterator& operator++();
+
+                DocumentIdIterator operator++(int);
+
+                bool operator==(const DocumentIdIterator& other) const;
+
+                bool operator!=(const DocumentIdIterator& other) const;
+
+            private:
+                friend class SearchServer;
+
+                DocumentIdIterator(const SearchServer* search_server, std::size_t ordinal);
+
+                // Переход к ближайшему неудаленному номеру не меньше текущего
+                void SkipRemoved();
+
+                const SearchServer* search_server_ = nullptr;
+                std::size_t ordinal_ = 0;
+        };
+
+        // Итераторы по ID документов в порядке добавления
+        DocumentIdIterator begin() const;
+
+        DocumentIdIterator end() const;
+
+        // Частоты слов документа, пустой словарь для отсутствующего документа
+        const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
         
-        // Поиск на совпадуние запросу
-        std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query,
+        // Поиск на совпадуние запросу. Найденные слова ссылаются на словарь индекса
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
             int document_id) const;
 
+        // Сопоставление с политикой выполнения (std::execution::seq / par / par_unseq):
+        // при par и par_unseq слова запроса проверяются параллельно
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy,
+            std::string_view raw_query, int document_id) const;
+
     private:
 
         struct DocumentData {
             int rating;
             DocumentStatus status;
+            DocumentOrdinal ordinal;
+            // Колличество слов без стоп-слов, частота слова - его колличество вхождений / word_count
+            std::uint32_t word_count;
         };
 
-        const std::set<std::string> stop_words_;
-        
-        std::map<std::string, std::map<int, double>> word_to_document_freqs_;
+        const std::set<std::string, std::less<>> stop_words_;
+
+        // Хранилище термов: каждое слово индекса хранится один раз,
+        // остальные структуры ссылаются на него через string_view
+        std::deque<std::string> term_pool_;
+
+        // Словарь термов: слово -> ID терма, ID - индекс слова в term_pool_
+        TermHashMap term_ids_;
+
+        // Отсортированная копия словаря для поиска по префиксу, собирается при первом таком поиске
+        mutable TermDictionary term_dictionary_;
+
+        std::size_t max_prefix_expansions_ = MAX_PREFIX_EXPANSIONS;
+
+        // Списки вхождений, индекс вектора - ID терма
+        std::vector<PostingList> postings_;
+
+        // Позиции вхождений, индексы совпадают с postings_. Пусто, если позиции не включены
+        std::vector<PositionList> positions_;
+
+        bool has_positions_ = false;
         
         std::map<int, DocumentData> documents_;
 
-        std::vector<int> document_ids_;
+        // ID документа по его порядковому номеру в индексе
+        std::vector<int> ordinal_to_document_id_;
+
+        // Номера удаленных документов. Их вхождения могут оставаться в списках до уплотнения,
+        // поэтому поиск пропускает отмеченные номера
+        DocumentBitset removed_ordinals_;
+
+        // Статус и рейтинг по порядковому номеру документа. Поиск проверяет предикат
+        // по этим столбцам, а не ищет документ в documents_ на каждое вхождение
+        std::vector<DocumentStatus> ordinal_statuses_;
+        std::vector<int> ordinal_ratings_;
+
+        // Норма длины документа для BM25 (1 / колличество слов без стоп-слов) по его номеру
+        std::vector<double> ordinal_length_norms_;
+
+        // Суммарное колличество слов документов индекса, по нему считается средняя длина документа
+        std::uint64_t total_word_count_ = 0;
+
+        // Прямой индекс: ID документа -> частоты его слов. После загрузки снимка и объединения
+        // собирается при первом обращении, читается через GetForwardIndex
+        ForwardIndex document_to_word_freqs_;
+
+        IdfRefreshPolicy idf_refresh_policy_ = IdfRefreshPolicy::LAZY;
+
+        // IDF по ID терма, при политике LAZY пересчитывается из константных методов поиска
+        mutable IdfCache idf_cache_;
+
+        QueryEvaluation query_evaluation_ = QueryEvaluation::EXHAUSTIVE;
+
+        QueryMatching query_matching_ = QueryMatching::ANY_TERM;
+
+        RelevanceModel relevance_model_ = RelevanceModel::TF_IDF;
+        double bm25_k1_ = BM25_K1;
+        double bm25_b_ = BM25_B;
+
+        std::uint64_t generation_ = 0;
+
+        // Прямой индекс, отложенная сборка выполняется при первом обращении
+        ForwardIndex::Documents& GetForwardIndex();
+
+        const ForwardIndex::Documents& GetForwardIndex() const;
+
+        void FillForwardIndex(ForwardIndex::Documents& documents) const;
+
+        // Выдача следующего порядкового номера документу: ID, статус, рейтинг и норма длины дописываются в столбцы
+        void AppendOrdinal(int document_id, DocumentStatus status, int rating, std::uint32_t word_count);
 
         // Проверка слова, является ли оно стоп-словом
-        bool IsStopWord(const std::string& word) const;
+        bool IsStopWord(std::string_view word) const;
 
         // Удаляем из запроса стоп-слова
-        std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+        std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+
+        // Терм словаря для слова, новое слово сохраняется в term_pool_ и получает пустой список вхождений
+        TermId InternTerm(std::string_view word);
+
+        // ID всех термов в порядке возрастания слов
+        std::vector<TermId> GetSortedTermIds() const;
+
+        // Часть пакета [begin, end), разобранная одним потоком. Термы части получают локальные ID,
+        // номера документов в списках вхождений - позиции в пакете
+        struct DocumentBatchChunk {
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            // Слова части, индекс - локальный ID терма
+            std::vector<std::string_view> words;
+            std::vector<PostingList> postings;
+            // Позиции слов, индексы совпадают с postings. Пусто, если позиции не включены
+            std::vector<PositionList> positions;
+            // Слова документов части по возрастанию: локальный ID терма и частота.
+            // Слова документа begin + i лежат в [document_term_offsets[i], document_term_offsets[i + 1])
+            std::vector<std::pair<TermId, double>> document_terms;
+            std::vector<std::size_t> document_term_offsets;
+            std::vector<std::uint32_t> document_word_counts;
+            bool is_valid = true;
+        };
+
+        // Проверка ID пакета до разбора: ID неотрицательны, новы и не повторяются
+        void CheckBatchDocumentIds(const std::vector<DocumentToAdd>& documents) const;
+
+        // Разбор документов части пакета, подсчет частот их слов и, если включены, позиций
+        void ParseDocumentBatchChunk(const std::vector<DocumentToAdd>& documents, DocumentBatchChunk& chunk) const;
+
+        // Слияние разобранных частей в индекс. Части покрывают идущие подряд номера документов,
+        // поэтому их списки вхождений дописываются по порядку частей за один проход,
+        // а словарь термов затрагивается один раз на слово части, а не на каждое вхождение
+        void MergeDocumentBatch(const std::vector<DocumentToAdd>& documents, const std::vector<DocumentBatchChunk>& chunks);
 
         // Подсчет среднего рейтинга
         static int ComputeAverageRating(const std::vector<int>& ratings);
 
-        struct QueryWord {
-            std::string data;
-            bool is_minus;
-            bool is_stop;
-        };
-        
-        // Парсинг запроса
-        QueryWord ParseQueryWord(std::string text) const;
+        // Подсчет IDF
+        double ComputeWordInverseDocumentFreq(const PostingList& postings) const;
+
+        // IDF терма для кэша, NaN для терма, который сейчас не встречается ни в одном документе
+        double ComputeTermInverseDocumentFreq(TermId term_id) const;
+
+        // IDF терма из кэша, для термов без закэшированного значения - подсчет на месте
+        double GetInverseDocumentFreq(TermId term_id) const;
+
+        // Обновление кэша IDF после изменения набора документов
+        void OnDocumentsChanged();
 
-        struct Query {
-            std::set<std::string> plus_words;
-            std::set<std::string> minus_words;
+        // Слова запроса, переведенные в ID термов этого сервера. Векторы идут параллельно словам Query,
+        // слову, которого нет в индексе, соответствует NO_TERM_ID. Запрос переводится один раз,
+        // дальше поиск работает только с ID
+        struct QueryTermIds {
+            explicit QueryTermIds(std::pmr::memory_resource* resource);
+
+            std::pmr::vector<TermId> plus_term_ids;
+            std::pmr::vector<TermId> minus_term_ids;
+            std::pmr::vector<TermId> proximity_term_ids;
         };
 
-        // Парсинг запроса
-        Query ParseQuery(const std::string& text) const;
+        // Перевод слов запроса в ID термов, память под векторы берется из resource
+        QueryTermIds ResolveQueryTerms(const Query& query, std::pmr::memory_resource* resource) const;
 
-        // Проверка слова на валидность
-        static bool IsValidWord(const std::string& word);
+        // Окончание MatchDocument для документа без минус-слов: matched_term_ids - плюс-слова запроса,
+        // найденные в документе. Проверяет минус-префиксы, ограничения близости и режим совпадения
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocumentTerms(const Query& query,
+            const QueryTermIds& query_term_ids, const DocumentData& document_data,
+            const std::vector<TermId>& matched_term_ids) const;
 
-        // Подсчет IDF
-        double ComputeWordInverseDocumentFreq(const std::string& word) const;
+        // Список вхождений терма или nullptr для NO_TERM_ID и терма без документов
+        const PostingList* FindPostings(TermId term_id) const;
+
+        // Поиск с учетом фраз и NEAR/k запроса: документы, нарушающие ограничения близости,
+        // отсекаются набором ID, который добавляется к предикату
+        template <typename ExecutionPolicy, typename DocumentPredicate>
+        void FindQueryDocuments(ExecutionPolicy&& policy, const Query& query, const QueryTermIds& query_term_ids,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentPredicate& document_predicate, TopDocuments& top_documents,
+            const DocumentBitset* excluded_ordinals = nullptr) const;
+
+        // ID документов, удовлетворяющих всем ограничениям близости запроса
+        std::vector<int> FindProximityDocumentIds(const Query& query, const QueryTermIds& query_term_ids) const;
+
+        // Оставляет в ordinals (по возрастанию) только документы, удовлетворяющие ограничениям близости.
+        // Списки вхождений слов ограничения пересекаются галопирующим поиском от текущей позиции
+        void FilterProximityDocuments(const Query& query, const QueryTermIds& query_term_ids,
+            std::vector<DocumentOrdinal>& ordinals) const;
+
+        // Объявление Шаблонной функции поисхха всех документов соответствующих запросу,
+        // найденные документы передаются в top_documents
+        template <typename DocumentPredicate>
+        void FindAllDocuments(const std::execution::sequenced_policy&,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            const std::vector<const PostingList*>& minus_postings,
+            DocumentPredicate& document_predicate, TopDocuments& top_documents,
+            const DocumentBitset* excluded_ordinals) const;
 
-        // Объявление Шаблонной функции поисхха всех документов соответствующих запросу
+        // Параллельный поиск: номера документов делятся на непересекающиеся шарды,
+        // каждый шард обходит все плюс-слова в том же порядке, что и последовательная версия,
+        // поэтому релевантность совпадает побитово
         template <typename DocumentPredicate>
-        std::vector<Document> FindAllDocuments(const Query& query,
-            DocumentPredicate& document_predicate) const;
+        void FindAllDocuments(const std::execution::parallel_policy&,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            const std::vector<const PostingList*>& minus_postings,
+            DocumentPredicate& document_predicate, TopDocuments& top_documents,
+            const DocumentBitset* excluded_ordinals) const;
+
+        // Поиск документов с номерами из [lower, upper). Минус-слова и предикат сводятся к проверке
+        // is_allowed(номер документа): для предикатов из document_predicates.h - к чтению маски,
+        // построенной один раз на шард, для остальных - к вызову предиката. Номера из excluded_ordinals
+        // и номера удаленных документов отсекаются до предиката
+        template <typename DocumentPredicate>
+        void FindShardDocuments(const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            const std::vector<const PostingList*>& minus_postings, DocumentOrdinal lower, DocumentOrdinal upper,
+            DocumentPredicate& document_predicate, TopDocuments& top_documents,
+            const DocumentBitset* excluded_ordinals) const;
+
+        // Подсчет релевантности допустимых документов: оценщик выбирается по модели релевантности
+        template <typename IsAllowed>
+        void ScoreShardDocuments(const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed,
+            TopDocuments& top_documents) const;
+
+        // Способ обхода выбирается по QueryMatching и QueryEvaluation, аккумулятор - по плотности номеров
+        template <typename Scorer, typename IsAllowed>
+        void ScoreShardDocuments(const Scorer& scorer,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed,
+            TopDocuments& top_documents) const;
+
+        template <typename Scorer, typename Accumulator, typename IsAllowed>
+        void AccumulateShardDocuments(const Scorer& scorer, Accumulator& accumulator,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed,
+            TopDocuments& top_documents) const;
+
+        // Курсор по списку вхождений плюс-слова для обхода документов по возрастанию номера
+        struct PostingCursor {
+            const PostingList* postings;
+            // Текущая позиция в списке
+            std::size_t position;
+            // Позиция слова среди найденных плюс-слов, в этом порядке складывается релевантность
+            std::size_t term_index;
+            double inverse_document_freq;
+            // Верхняя оценка вклада слова в релевантность любого документа
+            double max_score;
+        };
+
+        // Поиск документов из [lower, upper) со всеми плюс-словами: диапазоны списков пересекаются
+        // от самого короткого, затем курсоры списков продвигаются к документам пересечения
+        template <typename Scorer, typename IsAllowed>
+        void ScoreShardDocumentsConjunctive(const Scorer& scorer,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed,
+            TopDocuments& top_documents) const;
+
+        // Поиск документов с номерами из [lower, upper) с отсечением по верхним оценкам (MaxScore).
+        // Курсоры упорядочены по возрастанию оценки. Слова, сумма оценок которых ниже порога топа,
+        // не порождают кандидатов, а только проверяются для кандидатов остальных слов. Вклады
+        // остальных слов накапливаются окнами по MAX_SCORE_WINDOW_SIZE номеров
+        template <typename Scorer, typename IsAllowed>
+        void ScoreShardDocumentsMaxScore(const Scorer& scorer,
+            const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed,
+            TopDocuments& top_documents) const;
+
+        // Маска допустимых по ID документов из [lower, upper): 0 у документов вне наборов IdSet фильтра
+        // и у документов с минус-словами. Индекс - номер документа минус lower
+        template <typename DocumentFilter>
+        void FillDocumentMask(const DocumentFilter& document_filter, const std::vector<const PostingList*>& minus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, std::vector<std::uint8_t>& mask) const;
+
+        // Сброс в маске документов, не входящих в набор ID. Номера документов набора
+        // находятся по documents_, обход всех документов диапазона не нужен
+        void RestrictDocumentMask(const IdSet& document_filter, DocumentOrdinal lower, DocumentOrdinal upper,
+            std::uint8_t* mask) const;
+
+        template <typename Lhs, typename Rhs>
+        void RestrictDocumentMask(const AllOf<Lhs, Rhs>& document_filter, DocumentOrdinal lower, DocumentOrdinal upper,
+            std::uint8_t* mask) const;
+
+        // Фильтры по статусу и рейтингу проверяются по столбцам, маска им не нужна
+        template <typename DocumentFilter>
+        void RestrictDocumentMask(const DocumentFilter& document_filter, DocumentOrdinal lower, DocumentOrdinal upper,
+            std::uint8_t* mask) const;
+
+        // Отметка в excluded документов из [lower, upper) с минус-словами, индекс бита - номер минус lower.
+        // Возвращает false, если минус-слов нет и набор не заполнялся
+        static bool MarkExcludedDocuments(const std::vector<const PostingList*>& minus_postings,
+            DocumentOrdinal lower, DocumentOrdinal upper, DocumentBitset& excluded);
+
+        // Номера документов плотные: удалено не больше половины выданных номеров
+        bool HasDenseOrdinals() const;
+
+        // Удалялись ли документы: номера не переиспользуются, поэтому у удаленных документов номер остается
+        // до перенумерации в CompactOrdinals
+        bool HasRemovedOrdinals() const;
+
+        // Перенумерация документов без номеров удаленных: столбцы по номерам сжимаются, из списков вхождений
+        // и позиций вычищаются удаленные вхождения, а номера в них и в documents_ заменяются новыми.
+        // Новые номера идут в том же порядке, поэтому списки вхождений остаются отсортированными
+        void CompactOrdinals();
+
+        // Плюс-слова и плюс-префиксы запроса, найденные в индексе, вместе с их IDF. Префикс - один терм
+        // с объединенным списком вхождений, объединенные списки складываются в prefix_postings
+        std::vector<std::pair<const PostingList*, double>> GetPlusWordPostings(const Query& query,
+            const QueryTermIds& query_term_ids, std::vector<PostingList>& prefix_postings) const;
+
+        // Минус-слова запроса и слова минус-префиксов, найденные в индексе
+        std::vector<const PostingList*> GetMinusWordPostings(const Query& query, const QueryTermIds& query_term_ids) const;
+
+        // ID непустых термов с префиксом, не больше max_prefix_expansions_ первых по алфавиту
+        std::vector<TermId> ExpandPrefix(std::string_view prefix) const;
+
+        // Список вхождений префикса: список единственного слова или объединение списков слов,
+        // построенное в prefix_postings. Частоты слов одного документа складываются по алфавиту слов.
+        // nullptr, если в индексе нет слов с префиксом. Резерв prefix_postings должен вмещать
+        // новый список, иначе ранее полученные указатели на его элементы станут недействительны
+        const PostingList* FindPrefixPostings(std::string_view prefix, std::vector<PostingList>& prefix_postings) const;
 };
 
 // Реализация шаблонных функций
@@ -109,72 +608,550 @@ template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
     : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
 
-    if(std::any_of(stop_words.begin(), stop_words.end(), [](const std::string& word){return !IsValidWord(word);})){
+    if(std::any_of(stop_words.begin(), stop_words.end(), [](std::string_view word){return !IsValidWord(word);})){
         throw std::invalid_argument("Stop words have special symbols!");
     }      
 }
 
 // Реализация шаблонной функции поиска топа документов с функцией предикатом
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query,
-    DocumentPredicate document_predicate) const {
-            
-    const int MAX_RESULT_DOCUMENT_COUNT = 5;
-    Query query = ParseQuery(raw_query);
-    std::vector<Document> matched_documents = FindAllDocuments(query, document_predicate);
-
-    std::sort(matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            const double EPSILON = 1e-6;
-
-            if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                return lhs.rating > rhs.rating;
-            } else {
-                return lhs.relevance > rhs.relevance;
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count);
+}
+
+// Реализация шаблонной функции поиска топа документов с политикой выполнения
+template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+    // Полная сортировка всех найденных документов не нужна: отбираем max_count лучших на лету
+    TopDocuments top_documents(max_count);
+    FindTopDocuments(policy, raw_query, document_predicate, top_documents);
+    return top_documents.Extract();
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy>>
+void SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentPredicate document_predicate, TopDocuments& top_documents) const {
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, &query_buffer.resource);
+    const QueryTermIds query_term_ids = ResolveQueryTerms(query, &query_buffer.resource);
+
+    std::vector<PostingList> prefix_postings;
+    FindQueryDocuments(policy, query, query_term_ids, GetPlusWordPostings(query, query_term_ids, prefix_postings),
+        document_predicate, top_documents);
+}
+
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentStatus status, std::size_t max_count) const {
+    return FindTopDocuments(policy, raw_query, ByStatus{status}, max_count);
+}
+
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy>>
+void SearchServer::CollectTopDocuments(ExecutionPolicy&& policy, const Query& query,
+    const std::vector<double>& inverse_document_freqs, DocumentPredicate document_predicate,
+    TopDocuments& top_documents, const DocumentBitset* excluded_ordinals) const {
+
+    // Словари шардов разные, поэтому запрос переводится в ID термов каждым шардом
+    QueryBuffer query_buffer;
+    const QueryTermIds query_term_ids = ResolveQueryTerms(query, &query_buffer.resource);
+
+    std::vector<std::pair<const PostingList*, double>> plus_postings;
+    for (std::size_t i = 0; i < query.plus_words.size(); ++i) {
+        const PostingList* postings = FindPostings(query_term_ids.plus_term_ids[i]);
+        if (postings != nullptr) {
+            plus_postings.push_back({postings, inverse_document_freqs[i]});
+        }
+    }
+    // IDF префиксов идут следом за IDF плюс-слов
+    std::vector<PostingList> prefix_postings;
+    prefix_postings.reserve(query.plus_prefixes.size());
+    for (std::size_t i = 0; i < query.plus_prefixes.size(); ++i) {
+        const PostingList* postings = FindPrefixPostings(query.plus_prefixes[i], prefix_postings);
+        if (postings != nullptr) {
+            plus_postings.push_back({postings, inverse_document_freqs[query.plus_words.size() + i]});
+        }
+    }
+    FindQueryDocuments(policy, query, query_term_ids, plus_postings, document_predicate, top_documents,
+        excluded_ordinals);
+}
+
+// Удаление документа с политикой выполнения. Списки вхождений разных слов
+// не пересекаются, поэтому их можно обрабатывать параллельно
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    const auto document_it = documents_.find(document_id);
+    if (document_it == documents_.end()) {
+        return;
+    }
+    const DocumentOrdinal ordinal = document_it->second.ordinal;
+    ForwardIndex::Documents& forward_index = GetForwardIndex();
+    const auto word_freqs_it = forward_index.find(document_id);
+
+    std::vector<TermId> word_term_ids;
+    word_term_ids.reserve(word_freqs_it->second.size());
+    for (const auto& [word, _] : word_freqs_it->second) {
+        word_term_ids.push_back(term_ids_.Find(word));
+    }
+
+    // Вхождения только помечаются удаленными, список уплотняется, когда удалена половина его вхождений.
+    // Поэтому удаление стоит O(log df) на слово документа, а не сдвиг всего списка
+    std::for_each(GetLoopPolicy(policy), word_term_ids.begin(), word_term_ids.end(),
+        [this, ordinal](TermId term_id) {
+            PostingList& postings = postings_[term_id];
+            postings.Remove(ordinal);
+            if (postings.NeedsCompaction()) {
+                // Записи позиций вычищаются по пометкам вхождений, пока те еще в списке
+                if (has_positions_) {
+                    positions_[term_id].RemoveEntries(postings);
+                }
+                postings.Compact();
             }
+        });
+    removed_ordinals_.Set(ordinal);
+
+    forward_index.erase(word_freqs_it);
+    total_word_count_ -= document_it->second.word_count;
+    documents_.erase(document_it);
+    // Номера перенумеровываются, когда удалена половина из них: O(размера индекса) приходится
+    // на половину номеров удалений, а столбцы по номерам не растут без предела
+    if (!HasDenseOrdinals()) {
+        CompactOrdinals();
+    }
+    OnDocumentsChanged();
+}
+
+// Пакетное добавление с политикой выполнения. Части пакета разбираются независимо,
+// индекс меняется только при слиянии, когда все документы уже проверены
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+void SearchServer::AddDocuments(ExecutionPolicy&& policy, const std::vector<DocumentToAdd>& documents) {
+    CheckBatchDocumentIds(documents);
+
+    const std::size_t chunk_count = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>
+        ? 1
+        : std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()) * 4, documents.size());
+    std::vector<DocumentBatchChunk> chunks(chunk_count);
+    for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        chunks[chunk].begin = documents.size() * chunk / chunk_count;
+        chunks[chunk].end = documents.size() * (chunk + 1) / chunk_count;
+    }
+
+    std::for_each(GetLoopPolicy(policy), chunks.begin(), chunks.end(), [this, &documents](DocumentBatchChunk& chunk) {
+        ParseDocumentBatchChunk(documents, chunk);
     });
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    if (std::any_of(chunks.begin(), chunks.end(), [](const DocumentBatchChunk& chunk) { return !chunk.is_valid; })) {
+        throw std::invalid_argument("The document has invalid characters");
+    }
+    MergeDocumentBatch(documents, chunks);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+void SearchServer::FindQueryDocuments(ExecutionPolicy&& policy, const Query& query,
+    const QueryTermIds& query_term_ids, const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentPredicate& document_predicate, TopDocuments& top_documents, const DocumentBitset* excluded_ordinals) const {
+
+    // Если какого-то плюс-слова нет в индексе, ни один документ не содержит всех слов
+    if (query_matching_ == QueryMatching::ALL_TERMS
+        && plus_postings.size() < query.plus_words.size() + query.plus_prefixes.size()) {
+        return;
+    }
+
+    if (query.proximity_constraints.empty()) {
+        FindAllDocuments(GetLoopPolicy(policy), plus_postings, GetMinusWordPostings(query, query_term_ids),
+            document_predicate, top_documents, excluded_ordinals);
+        return;
+    }
+
+    const IdSet proximity_documents(FindProximityDocumentIds(query, query_term_ids));
+    if constexpr (IS_DOCUMENT_FILTER<DocumentPredicate>) {
+        // Набор ID фильтра переводится в маску так же, как набор пользователя
+        AllOf<std::decay_t<DocumentPredicate>, IdSet> document_filter{document_predicate, proximity_documents};
+        FindAllDocuments(GetLoopPolicy(policy), plus_postings, GetMinusWordPostings(query, query_term_ids),
+            document_filter, top_documents, excluded_ordinals);
+    } else {
+        auto proximity_predicate = [&](int document_id, DocumentStatus status, int rating) {
+            return proximity_documents(document_id, status, rating)
+                && document_predicate(document_id, status, rating);
+        };
+        FindAllDocuments(GetLoopPolicy(policy), plus_postings, GetMinusWordPostings(query, query_term_ids),
+            proximity_predicate, top_documents, excluded_ordinals);
+    }
+}
+
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy&& policy,
+    std::string_view raw_query, int document_id) const {
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, &query_buffer.resource);
+    const QueryTermIds query_term_ids = ResolveQueryTerms(query, &query_buffer.resource);
+    const DocumentData& document_data = documents_.at(document_id);
+
+    const auto contains_document = [this, &document_data](TermId term_id) {
+        const PostingList* postings = FindPostings(term_id);
+        return postings != nullptr && postings->Contains(document_data.ordinal);
+    };
+    const auto& loop_policy = GetLoopPolicy(policy);
+    if (std::any_of(loop_policy, query_term_ids.minus_term_ids.begin(), query_term_ids.minus_term_ids.end(),
+        contains_document)) {
+        return {std::vector<std::string_view>{}, document_data.status};
     }
-    return matched_documents;
+    // Найденные плюс-слова сохраняют порядок запроса при любой политике
+    std::vector<TermId> matched_term_ids(query_term_ids.plus_term_ids.size());
+    matched_term_ids.erase(std::copy_if(loop_policy, query_term_ids.plus_term_ids.begin(),
+        query_term_ids.plus_term_ids.end(), matched_term_ids.begin(), contains_document), matched_term_ids.end());
+    return MatchDocumentTerms(query, query_term_ids, document_data, matched_term_ids);
 }
 
 // Реализация аблонной функции поисхха всех документов соответствующих запросу
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query,
-    DocumentPredicate& document_predicate) const {
+void SearchServer::FindAllDocuments(const std::execution::sequenced_policy&,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    const std::vector<const PostingList*>& minus_postings,
+    DocumentPredicate& document_predicate, TopDocuments& top_documents,
+    const DocumentBitset* excluded_ordinals) const {
 
-    std::map<int, double> document_to_relevance;
-            
-    for (const std::string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    const auto ordinal_count = static_cast<DocumentOrdinal>(ordinal_to_document_id_.size());
+
+    FindShardDocuments(plus_postings, minus_postings, 0, ordinal_count, document_predicate, top_documents,
+        excluded_ordinals);
+}
+
+// Реализация параллельной функции поиска всех документов соответствующих запросу
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const std::execution::parallel_policy&,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    const std::vector<const PostingList*>& minus_postings,
+    DocumentPredicate& document_predicate, TopDocuments& top_documents,
+    const DocumentBitset* excluded_ordinals) const {
+
+    if (ordinal_to_document_id_.empty()) {
+        return;
+    }
+
+    // Границы шардов: номера документов [0, ordinal_count) делятся на равные части
+    const std::size_t ordinal_count = ordinal_to_document_id_.size();
+    const std::size_t shard_count = std::min<std::size_t>(
+        std::max(1u, std::thread::hardware_concurrency()) * 4, ordinal_count);
+
+    // Шард отбирает свой топ, блокировки не нужны
+    std::vector<TopDocuments> shard_top_documents(shard_count, TopDocuments(top_documents.GetMaxCount()));
+    std::vector<std::size_t> shard_indexes(shard_count);
+    std::iota(shard_indexes.begin(), shard_indexes.end(), 0);
+
+    std::for_each(std::execution::par, shard_indexes.begin(), shard_indexes.end(),
+        [&](std::size_t shard) {
+            const auto lower = static_cast<DocumentOrdinal>(ordinal_count * shard / shard_count);
+            const auto upper = static_cast<DocumentOrdinal>(ordinal_count * (shard + 1) / shard_count);
+            FindShardDocuments(plus_postings, minus_postings, lower, upper, document_predicate,
+                shard_top_documents[shard], excluded_ordinals);
+    });
+
+    // Лучшие документы всего индекса входят в топы своих шардов
+    for (TopDocuments& shard_top : shard_top_documents) {
+        for (const Document& document : shard_top.Extract()) {
+            top_documents.Push(document);
+        }
+    }
+}
+
+// Поиск документов с номерами из [lower, upper)
+template <typename DocumentPredicate>
+void SearchServer::FindShardDocuments(const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    const std::vector<const PostingList*>& minus_postings, DocumentOrdinal lower, DocumentOrdinal upper,
+    DocumentPredicate& document_predicate, TopDocuments& top_documents,
+    const DocumentBitset* excluded_ordinals) const {
+
+    if constexpr (IS_DOCUMENT_FILTER<DocumentPredicate>) {
+        // Статус и рейтинг сравниваются со столбцами прямо в цикле, маска строится,
+        // только если фильтр ограничивает ID или в запросе есть минус-слова
+        static thread_local std::vector<std::uint8_t> mask;
+        const bool has_mask = HasIdSet<std::decay_t<DocumentPredicate>>::value || !minus_postings.empty();
+        if (has_mask) {
+            FillDocumentMask(document_predicate, minus_postings, lower, upper, mask);
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                
-        for (const auto &[document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        // Копия фильтра и указатели на столбцы не перечитываются из памяти на каждое вхождение
+        const DocumentStatus* statuses = ordinal_statuses_.data();
+        const int* ratings = ordinal_ratings_.data();
+        const DocumentBitset* removed = HasRemovedOrdinals() ? &removed_ordinals_ : nullptr;
+        ScoreShardDocuments(plus_postings, lower, upper,
+            [document_filter = document_predicate, statuses, ratings, removed, excluded_ordinals, has_mask, lower](
+                DocumentOrdinal ordinal) {
+                return (!has_mask || mask[ordinal - lower] != 0)
+                    && (removed == nullptr || !removed->Test(ordinal))
+                    && (excluded_ordinals == nullptr || !excluded_ordinals->Test(ordinal))
+                    && document_filter.MatchesColumns(statuses[ordinal], ratings[ordinal]);
+            }, top_documents);
+    } else {
+        // Сначала собираем документы с минус-словами, чтобы не считать для них релевантность
+        static thread_local DocumentBitset excluded;
+        const bool has_excluded = MarkExcludedDocuments(minus_postings, lower, upper, excluded);
+        const bool has_removed = HasRemovedOrdinals();
+        ScoreShardDocuments(plus_postings, lower, upper, [&](DocumentOrdinal ordinal) {
+            return !(has_excluded && excluded.Test(ordinal - lower))
+                && !(has_removed && removed_ordinals_.Test(ordinal))
+                && !(excluded_ordinals != nullptr && excluded_ordinals->Test(ordinal))
+                && document_predicate(ordinal_to_document_id_[ordinal], ordinal_statuses_[ordinal],
+                    ordinal_ratings_[ordinal]);
+        }, top_documents);
+    }
+}
+
+template <typename IsAllowed>
+void SearchServer::ScoreShardDocuments(const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed, TopDocuments& top_documents) const {
+
+    if (relevance_model_ == RelevanceModel::BM25) {
+        const double average_length = documents_.empty() ? 0.0
+            : static_cast<double>(total_word_count_) / static_cast<double>(documents_.size());
+        ScoreShardDocuments(Bm25Scorer(ordinal_length_norms_.data(), average_length, bm25_k1_, bm25_b_),
+            plus_postings, lower, upper, is_allowed, top_documents);
+    } else {
+        ScoreShardDocuments(TfIdfScorer{}, plus_postings, lower, upper, is_allowed, top_documents);
+    }
+}
+
+template <typename Scorer, typename IsAllowed>
+void SearchServer::ScoreShardDocuments(const Scorer& scorer,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed, TopDocuments& top_documents) const {
+
+    // Пересечение уже отсекает большинство документов, отсечение по оценкам ему не нужно
+    if (query_matching_ == QueryMatching::ALL_TERMS) {
+        ScoreShardDocumentsConjunctive(scorer, plus_postings, lower, upper, is_allowed, top_documents);
+        return;
+    }
+    if (query_evaluation_ == QueryEvaluation::MAX_SCORE) {
+        ScoreShardDocumentsMaxScore(scorer, plus_postings, lower, upper, is_allowed, top_documents);
+        return;
+    }
+
+    // Аккумуляторы переиспользуются между запросами одного потока
+    if (HasDenseOrdinals()) {
+        static thread_local DenseRelevanceAccumulator accumulator;
+        AccumulateShardDocuments(scorer, accumulator, plus_postings, lower, upper, is_allowed, top_documents);
+    } else {
+        static thread_local HashRelevanceAccumulator accumulator;
+        AccumulateShardDocuments(scorer, accumulator, plus_postings, lower, upper, is_allowed, top_documents);
+    }
+}
+
+template <typename Scorer, typename Accumulator, typename IsAllowed>
+void SearchServer::AccumulateShardDocuments(const Scorer& scorer, Accumulator& accumulator,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed, TopDocuments& top_documents) const {
+
+    accumulator.Reset(lower, upper);
+    for (const auto& [postings, inverse_document_freq] : plus_postings) {
+        for (std::size_t i = postings->LowerBound(lower);
+            i < postings->size() && postings->document_ordinals[i] < upper; ++i) {
+            const DocumentOrdinal ordinal = postings->document_ordinals[i];
+            if (is_allowed(ordinal)) {
+                accumulator.Add(ordinal, scorer.Score(postings->term_freqs[i], inverse_document_freq, ordinal));
             }
         }
     }
-    for (const std::string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    accumulator.ForEach([&](DocumentOrdinal ordinal, double relevance) {
+        top_documents.Push({ordinal_to_document_id_[ordinal], relevance, ordinal_ratings_[ordinal]});
+    });
+}
+
+template <typename Scorer, typename IsAllowed>
+void SearchServer::ScoreShardDocumentsConjunctive(const Scorer& scorer,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed, TopDocuments& top_documents) const {
+
+    if (plus_postings.empty()) {
+        return;
+    }
+    // Позиции начала и конца диапазона [lower, upper) в каждом списке
+    std::vector<std::size_t> positions(plus_postings.size());
+    std::vector<std::size_t> ends(plus_postings.size());
+    for (std::size_t term_index = 0; term_index < plus_postings.size(); ++term_index) {
+        const PostingList* postings = plus_postings[term_index].first;
+        positions[term_index] = postings->LowerBound(lower);
+        ends[term_index] = postings->LowerBound(upper, positions[term_index]);
+    }
+    std::vector<std::size_t> term_order(plus_postings.size());
+    std::iota(term_order.begin(), term_order.end(), 0);
+    std::sort(term_order.begin(), term_order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return ends[lhs] - positions[lhs] < ends[rhs] - positions[rhs];
+    });
+
+    // Кандидаты - номера самого короткого диапазона, каждое следующее пересечение выполняется на месте
+    static thread_local std::vector<DocumentOrdinal> candidates;
+    const std::size_t rarest = term_order.front();
+    const DocumentOrdinal* rarest_ordinals = plus_postings[rarest].first->document_ordinals.data();
+    candidates.assign(rarest_ordinals + positions[rarest], rarest_ordinals + ends[rarest]);
+    std::size_t candidate_count = candidates.size();
+    for (std::size_t i = 1; i < term_order.size() && candidate_count > 0; ++i) {
+        const std::size_t term_index = term_order[i];
+        candidate_count = Intersect(candidates.data(), candidate_count,
+            plus_postings[term_index].first->document_ordinals.data() + positions[term_index],
+            ends[term_index] - positions[term_index], candidates.data());
+    }
+
+    for (std::size_t i = 0; i < candidate_count; ++i) {
+        const DocumentOrdinal candidate = candidates[i];
+        if (!is_allowed(candidate)) {
             continue;
         }
+        // Вклады складываются в порядке плюс-слов, как при полном переборе
+        double relevance = 0.0;
+        for (std::size_t term_index = 0; term_index < plus_postings.size(); ++term_index) {
+            const auto& [postings, inverse_document_freq] = plus_postings[term_index];
+            positions[term_index] = postings->LowerBound(candidate, positions[term_index]);
+            relevance += scorer.Score(postings->term_freqs[positions[term_index]], inverse_document_freq, candidate);
+        }
+        top_documents.Push({ordinal_to_document_id_[candidate], relevance, ordinal_ratings_[candidate]});
+    }
+}
+
+template <typename Scorer, typename IsAllowed>
+void SearchServer::ScoreShardDocumentsMaxScore(const Scorer& scorer,
+    const std::vector<std::pair<const PostingList*, double>>& plus_postings,
+    DocumentOrdinal lower, DocumentOrdinal upper, const IsAllowed& is_allowed, TopDocuments& top_documents) const {
+
+    // Верхние оценки вкладов дает оценщик, отрицательный IDF дает неположительный вклад
+    std::vector<PostingCursor> cursors;
+    cursors.reserve(plus_postings.size());
+    for (std::size_t term_index = 0; term_index < plus_postings.size(); ++term_index) {
+        const auto& [postings, inverse_document_freq] = plus_postings[term_index];
+        cursors.push_back({postings, postings->LowerBound(lower), term_index, inverse_document_freq,
+            scorer.GetMaxScore(postings->max_term_freq, inverse_document_freq)});
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const PostingCursor& lhs, const PostingCursor& rhs) {
+        return lhs.max_score < rhs.max_score;
+    });
+    // prefix_scores[i] - сумма оценок курсоров [0, i)
+    std::vector<double> prefix_scores(cursors.size() + 1, 0.0);
+    for (std::size_t i = 0; i < cursors.size(); ++i) {
+        prefix_scores[i + 1] = prefix_scores[i] + cursors[i].max_score;
+    }
+
+    // Документы обходятся окнами по MAX_SCORE_WINDOW_SIZE номеров. Вклады основных слов окна
+    // накапливаются в массиве, как при полном переборе, поэтому кандидат не ищется среди всех
+    // курсоров на каждый документ. Отметки кандидатов окна перебираются по возрастанию номера
+    constexpr std::size_t WORD_BITS = 64;
+    static thread_local std::vector<double> window_scores(MAX_SCORE_WINDOW_SIZE, 0.0);
+    std::array<std::uint64_t, MAX_SCORE_WINDOW_SIZE / WORD_BITS> window_hits{};
+    // Позиции основных курсоров в начале окна, от них ищутся вхождения кандидатов окна
+    std::vector<std::size_t> probes(cursors.size());
+    // Вклады слов в релевантность кандидата по term_index
+    std::vector<double> term_scores(plus_postings.size());
+
+    // Курсоры [0, first_essential) кандидатов не порождают
+    std::size_t first_essential = 0;
+    while (true) {
+        // Слова делятся на основные и дополнительные один раз на окно, порог топа только растет
+        double threshold = top_documents.GetMinRelevanceToEnter();
+        while (first_essential < cursors.size() && prefix_scores[first_essential + 1] < threshold) {
+            ++first_essential;
+        }
+
+        // Окно начинается с наименьшего текущего номера основных курсоров, пустые промежутки пропускаются
+        DocumentOrdinal window_lower = upper;
+        for (std::size_t i = first_essential; i < cursors.size(); ++i) {
+            const PostingCursor& cursor = cursors[i];
+            if (cursor.position < cursor.postings->size()) {
+                window_lower = std::min(window_lower, cursor.postings->document_ordinals[cursor.position]);
+            }
+        }
+        if (window_lower >= upper) {
+            break;
+        }
+        const auto window_upper = static_cast<DocumentOrdinal>(
+            std::min<std::size_t>(upper, std::size_t{window_lower} + MAX_SCORE_WINDOW_SIZE));
+
+        for (std::size_t i = first_essential; i < cursors.size(); ++i) {
+            PostingCursor& cursor = cursors[i];
+            probes[i] = cursor.position;
+            const DocumentOrdinal* ordinals = cursor.postings->document_ordinals.data();
+            const double* term_freqs = cursor.postings->term_freqs.data();
+            const std::size_t size = cursor.postings->size();
+            for (; cursor.position < size && ordinals[cursor.position] < window_upper; ++cursor.position) {
+                const DocumentOrdinal ordinal = ordinals[cursor.position];
+                const std::size_t offset = ordinal - window_lower;
+                window_scores[offset] += scorer.Score(term_freqs[cursor.position], cursor.inverse_document_freq, ordinal);
+                window_hits[offset / WORD_BITS] |= std::uint64_t{1} << (offset % WORD_BITS);
+            }
+        }
+
+        for (std::size_t word = 0; word < window_hits.size(); ++word) {
+            for (std::uint64_t bits = std::exchange(window_hits[word], 0); bits != 0; bits &= bits - 1) {
+                const std::size_t offset = word * WORD_BITS + static_cast<std::size_t>(__builtin_ctzll(bits));
+                const auto candidate = static_cast<DocumentOrdinal>(window_lower + offset);
+                double score_bound = prefix_scores[first_essential] + std::exchange(window_scores[offset], 0.0);
+                threshold = top_documents.GetMinRelevanceToEnter();
+                if (score_bound < threshold || !is_allowed(candidate)) {
+                    continue;
+                }
 
-        for (const auto &[document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+                // Дополнительные курсоры проверяются от самого весомого, пока оценка не опустится ниже порога
+                std::fill(term_scores.begin(), term_scores.end(), 0.0);
+                for (std::size_t i = first_essential; i > 0 && score_bound >= threshold; --i) {
+                    PostingCursor& cursor = cursors[i - 1];
+                    cursor.position = cursor.postings->LowerBound(candidate, cursor.position);
+                    score_bound -= cursor.max_score;
+                    if (cursor.position < cursor.postings->size()
+                        && cursor.postings->document_ordinals[cursor.position] == candidate) {
+                        const double score = scorer.Score(cursor.postings->term_freqs[cursor.position],
+                            cursor.inverse_document_freq, candidate);
+                        term_scores[cursor.term_index] = score;
+                        score_bound += score;
+                    }
+                }
+                if (score_bound < threshold) {
+                    continue;
+                }
+
+                for (std::size_t i = first_essential; i < cursors.size(); ++i) {
+                    const PostingCursor& cursor = cursors[i];
+                    probes[i] = cursor.postings->LowerBound(candidate, probes[i]);
+                    if (probes[i] < cursor.position && cursor.postings->document_ordinals[probes[i]] == candidate) {
+                        term_scores[cursor.term_index] = scorer.Score(cursor.postings->term_freqs[probes[i]],
+                            cursor.inverse_document_freq, candidate);
+                    }
+                }
+                // Вклады складываются в порядке плюс-слов, как при полном переборе. Нулевой вклад
+                // отсутствующего слова сумму не меняет
+                double relevance = 0.0;
+                for (const double term_score : term_scores) {
+                    relevance += term_score;
+                }
+                top_documents.Push({ordinal_to_document_id_[candidate], relevance, ordinal_ratings_[candidate]});
+            }
         }
     }
-    std::vector<Document> matched_documents;
-    
-    for (const auto &[document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+}
+
+template <typename DocumentFilter>
+void SearchServer::FillDocumentMask(const DocumentFilter& document_filter,
+    const std::vector<const PostingList*>& minus_postings, DocumentOrdinal lower, DocumentOrdinal upper,
+    std::vector<std::uint8_t>& mask) const {
+    mask.assign(upper - lower, 1);
+    RestrictDocumentMask(document_filter, lower, upper, mask.data());
+    for (const PostingList* postings : minus_postings) {
+        for (std::size_t i = postings->LowerBound(lower);
+            i < postings->size() && postings->document_ordinals[i] < upper; ++i) {
+            mask[postings->document_ordinals[i] - lower] = 0;
+        }
     }
+}
+
+template <typename Lhs, typename Rhs>
+void SearchServer::RestrictDocumentMask(const AllOf<Lhs, Rhs>& document_filter, DocumentOrdinal lower,
+    DocumentOrdinal upper, std::uint8_t* mask) const {
+    RestrictDocumentMask(document_filter.lhs, lower, upper, mask);
+    RestrictDocumentMask(document_filter.rhs, lower, upper, mask);
+}
 
-    return matched_documents;
+template <typename DocumentFilter>
+void SearchServer::RestrictDocumentMask(const DocumentFilter&, DocumentOrdinal, DocumentOrdinal, std::uint8_t*) const {
 }
\ No newline at end of file
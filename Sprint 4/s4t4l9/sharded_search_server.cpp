@@ -0,0 +1,79 @@
+#include "sharded_search_server.h"
+
+#include "string_processing.h"
+
+ShardedSearchServer::Shard::Shard(std::string_view stop_words_text)
+    : search_server(stop_words_text) {
+}
+
+ShardedSearchServer::ShardedSearchServer(std::string_view stop_words_text, std::size_t shard_count)
+    : stop_words_(MakeUniqueNonEmptyStrings(SplitIntoWords(stop_words_text))) {
+
+    if (shard_count == 0) {
+        throw std::invalid_argument("Shard count must be positive");
+    }
+    // Шард сам проверяет стоп-слова и бросает исключение при недопустимых символах
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        shards_.emplace_back(stop_words_text);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    Shard& shard = GetShard(document_id);
+    const std::unique_lock lock(shard.mutex);
+    shard.search_server.AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    Shard& shard = GetShard(document_id);
+    const std::unique_lock lock(shard.mutex);
+    shard.search_server.RemoveDocument(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    std::size_t max_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_count);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments(std::execution::seq, raw_query);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    const auto locks = LockShards();
+    int document_count = 0;
+    for (const Shard& shard : shards_) {
+        document_count += shard.search_server.GetDocumentCount();
+    }
+    return document_count;
+}
+
+std::size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(
+    std::string_view raw_query, int document_id) const {
+    const Shard& shard = GetShard(document_id);
+    const std::shared_lock lock(shard.mutex);
+    return shard.search_server.MatchDocument(raw_query, document_id);
+}
+
+ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) {
+    return shards_[std::hash<int>{}(document_id) % shards_.size()];
+}
+
+const ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) const {
+    return shards_[std::hash<int>{}(document_id) % shards_.size()];
+}
+
+// Шарды блокируются всегда в одном порядке, а запись держит только один шард, поэтому взаимных блокировок нет
+std::vector<std::shared_lock<std::shared_mutex>> ShardedSearchServer::LockShards() const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shards_.size());
+    for (const Shard& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+    }
+    return locks;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <execution>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "query.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Поисковый сервер, разбитый на несколько SearchServer по хешу ID документа.
+// Документы разных шардов добавляются параллельно, запрос рассылается во все шарды,
+// а их топы сливаются. IDF считается по всем шардам сразу, поэтому выдача совпадает
+// с выдачей одного SearchServer с теми же документами
+class ShardedSearchServer {
+    
+    public:
+        explicit ShardedSearchServer(std::string_view stop_words_text,
+            std::size_t shard_count = std::max(1u, std::thread::hardware_concurrency()));
+
+        // Можно вызывать из нескольких потоков: блокируется только шард документа
+        void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+            const std::vector<int>& ratings);
+
+        void RemoveDocument(int document_id);
+
+        template <typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+            std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+        // Политика задает, обходятся шарды последовательно или параллельно
+        template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+            DocumentPredicate document_predicate, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+            DocumentStatus status, std::size_t max_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy> = true>
+        std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+        int GetDocumentCount() const;
+
+        std::size_t GetShardCount() const;
+
+        std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+            int document_id) const;
+
+    private:
+        struct Shard {
+            explicit Shard(std::string_view stop_words_text);
+
+            // Добавления и удаления берут монопольную блокировку, запросы - разделяемую
+            mutable std::shared_mutex mutex;
+            SearchServer search_server;
+        };
+
+        const std::set<std::string, std::less<>> stop_words_;
+        std::deque<Shard> shards_;
+
+        Shard& GetShard(int document_id);
+
+        const Shard& GetShard(int document_id) const;
+
+        // Разделяемые блокировки всех шардов на время запроса
+        std::vector<std::shared_lock<std::shared_mutex>> LockShards() const;
+};
+
+// Реализация шаблонных функций
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentPredicate document_predicate, std::size_t max_count) const {
+
+    QueryBuffer query_buffer;
+    const Query query = ParseQuery(raw_query, stop_words_, &query_buffer.resource);
+
+    const auto locks = LockShards();
+    std::vector<const SearchServer*> search_servers;
+    for (const Shard& shard : shards_) {
+        search_servers.push_back(&shard.search_server);
+    }
+    const std::vector<double> inverse_document_freqs = SearchServer::ComputeInverseDocumentFreqs(search_servers, query);
+
+    // Каждый шард отбирает свой топ, лучшие документы всего индекса входят в топы своих шардов
+    std::vector<TopDocuments> shard_top_documents(shards_.size(), TopDocuments(max_count));
+    std::vector<std::size_t> shard_indexes(shards_.size());
+    std::iota(shard_indexes.begin(), shard_indexes.end(), 0);
+
+    std::for_each(GetLoopPolicy(policy), shard_indexes.begin(), shard_indexes.end(),
+        [&](std::size_t shard) {
+            shards_[shard].search_server.CollectTopDocuments(std::execution::seq, query, inverse_document_freqs,
+                document_predicate, shard_top_documents[shard]);
+    });
+
+    TopDocuments top_documents(max_count);
+    for (TopDocuments& shard_top : shard_top_documents) {
+        for (const Document& document : shard_top.Extract()) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Extract();
+}
+
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+    DocumentStatus status, std::size_t max_count) const {
+    return FindTopDocuments(policy, raw_query, ByStatus{status}, max_count);
+}
+
+template <typename ExecutionPolicy, EnableIfExecutionPolicy<ExecutionPolicy>>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy&& policy,
+    std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "compressed_postings.h"
+
+std::uint64_t ComputeSnapshotChecksum(const std::byte* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<std::uint64_t>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+SnapshotWriter::SnapshotWriter()
+        : header_{}
+        , buffer_(sizeof(SnapshotHeader)) {
+}
+
+void SnapshotWriter::Save(const std::string& path) {
+    header_.magic = SNAPSHOT_MAGIC;
+    header_.version = SNAPSHOT_VERSION;
+    header_.header_size = sizeof(SnapshotHeader);
+    header_.file_size = buffer_.size();
+    header_.checksum = ComputeSnapshotChecksum(buffer_.data() + sizeof(SnapshotHeader),
+        buffer_.size() - sizeof(SnapshotHeader));
+    std::memcpy(buffer_.data(), &header_, sizeof(SnapshotHeader));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Can't create snapshot file " + path);
+    }
+    out.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    if (!out) {
+        throw std::runtime_error("Can't write snapshot file " + path);
+    }
+}
+
+SnapshotReader::SnapshotReader(const std::string& path, bool verify_checksum)
+        : file_(path)
+        , header_(nullptr) {
+    if (file_.size() < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("Snapshot file is too small");
+    }
+    header_ = reinterpret_cast<const SnapshotHeader*>(file_.data());
+
+    if (header_->magic != SNAPSHOT_MAGIC) {
+        throw std::runtime_error("File is not a search server snapshot");
+    }
+    if (header_->version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+    if (header_->header_size != sizeof(SnapshotHeader) || header_->file_size != file_.size()) {
+        throw std::runtime_error("Snapshot header doesn't match file size");
+    }
+    if (verify_checksum && header_->checksum != ComputeSnapshotChecksum(file_.data() + sizeof(SnapshotHeader),
+        file_.size() - sizeof(SnapshotHeader))) {
+        throw std::runtime_error("Snapshot checksum mismatch");
+    }
+
+    ValidateSection(&SnapshotHeader::stop_word_offsets, sizeof(std::uint64_t));
+    ValidateSection(&SnapshotHeader::stop_word_chars, sizeof(char));
+    ValidateSection(&SnapshotHeader::term_offsets, sizeof(std::uint64_t));
+    ValidateSection(&SnapshotHeader::term_chars, sizeof(char));
+    ValidateSection(&SnapshotHeader::posting_block_offsets, sizeof(std::uint64_t));
+    ValidateSection(&SnapshotHeader::posting_blocks, sizeof(PostingBlock));
+    ValidateSection(&SnapshotHeader::posting_data, sizeof(std::uint8_t));
+    ValidateSection(&SnapshotHeader::document_ids, sizeof(std::int32_t));
+    ValidateSection(&SnapshotHeader::document_ratings, sizeof(std::int32_t));
+    ValidateSection(&SnapshotHeader::document_statuses, sizeof(std::uint8_t));
+    ValidateSection(&SnapshotHeader::document_word_counts, sizeof(std::uint32_t));
+
+    ValidateOffsets(&SnapshotHeader::stop_word_offsets, &SnapshotHeader::stop_word_chars);
+    ValidateOffsets(&SnapshotHeader::term_offsets, &SnapshotHeader::term_chars);
+    ValidateOffsets(&SnapshotHeader::posting_block_offsets, &SnapshotHeader::posting_blocks);
+    ValidatePostingBlocks();
+
+    const std::size_t document_count = Count(&SnapshotHeader::document_ids);
+    if (Count(&SnapshotHeader::term_offsets) != Count(&SnapshotHeader::posting_block_offsets)
+        || Count(&SnapshotHeader::document_ratings) != document_count
+        || Count(&SnapshotHeader::document_statuses) != document_count
+        || Count(&SnapshotHeader::document_word_counts) != document_count) {
+        throw std::runtime_error("Snapshot sections have inconsistent sizes");
+    }
+}
+
+const SnapshotHeader& SnapshotReader::GetHeader() const {
+    return *header_;
+}
+
+std::size_t SnapshotReader::Count(SnapshotSectionField section) const {
+    return (header_->*section).count;
+}
+
+std::string_view SnapshotReader::String(SnapshotSectionField offsets, SnapshotSectionField chars,
+    std::size_t index) const {
+    const std::uint64_t* string_offsets = Section<std::uint64_t>(offsets);
+    return {Section<char>(chars) + string_offsets[index], string_offsets[index + 1] - string_offsets[index]};
+}
+
+void SnapshotReader::ValidateSection(SnapshotSectionField section, std::size_t element_size) const {
+    const SnapshotSection& location = header_->*section;
+    // Секции выровнены по 8 байт, этого достаточно для любого типа элементов снимка
+    if (location.offset < sizeof(SnapshotHeader) || location.offset % std::min<std::size_t>(element_size, 8) != 0
+        || location.offset > file_.size()
+        || location.count > (file_.size() - location.offset) / element_size) {
+        throw std::runtime_error("Snapshot section is out of file bounds");
+    }
+}
+
+void SnapshotReader::ValidateOffsets(SnapshotSectionField offsets, SnapshotSectionField data) const {
+    const std::size_t count = Count(offsets);
+    const std::uint64_t* values = Section<std::uint64_t>(offsets);
+    if (count == 0 || values[0] != 0 || values[count - 1] != Count(data)) {
+        throw std::runtime_error("Snapshot offsets are inconsistent");
+    }
+    for (std::size_t i = 1; i < count; ++i) {
+        if (values[i] < values[i - 1]) {
+            throw std::runtime_error("Snapshot offsets are inconsistent");
+        }
+    }
+}
+
+
+void SnapshotReader::ValidatePostingBlocks() const {
+    const PostingBlock* blocks = Section<PostingBlock>(&SnapshotHeader::posting_blocks);
+    const std::size_t data_size = Count(&SnapshotHeader::posting_data);
+    for (std::size_t i = 0; i < Count(&SnapshotHeader::posting_blocks); ++i) {
+        if (blocks[i].offset > data_size || blocks[i].byte_size > data_size - blocks[i].offset) {
+            throw std::runtime_error("Snapshot posting block is out of bounds");
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Формат снимка индекса. Числа хранятся в порядке байт платформы, каждая секция
+// выровнена по 8 байт, поэтому массивы можно читать прямо из отображенной памяти
+constexpr std::array<char, 8> SNAPSHOT_MAGIC = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+constexpr std::uint32_t SNAPSHOT_VERSION = 2;
+
+// Расположение массива в файле
+struct SnapshotSection {
+    // Смещение от начала файла в байтах
+    std::uint64_t offset = 0;
+    // Колличество элементов
+    std::uint64_t count = 0;
+};
+
+struct SnapshotHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t file_size;
+    // FNV-1a по всем байтам после заголовка
+    std::uint64_t checksum;
+
+    // Стоп-слова: слово i - символы [stop_word_offsets[i], stop_word_offsets[i + 1])
+    SnapshotSection stop_word_offsets;
+    SnapshotSection stop_word_chars;
+
+    // Словарь термов по возрастанию, индекс терма в словаре - его ID в снимке
+    SnapshotSection term_offsets;
+    SnapshotSection term_chars;
+
+    // Сжатые списки вхождений (compressed_postings.h): терм i - блоки
+    // [posting_block_offsets[i], posting_block_offsets[i + 1]), смещения блоков - в posting_data
+    SnapshotSection posting_block_offsets;
+    SnapshotSection posting_blocks;
+    SnapshotSection posting_data;
+
+    // Таблица документов по возрастанию ID, индекс в таблице - номер документа
+    SnapshotSection document_ids;
+    SnapshotSection document_ratings;
+    SnapshotSection document_statuses;
+    // Колличество слов документа, по нему частота слова восстанавливается из колличества вхождений
+    SnapshotSection document_word_counts;
+};
+
+// Указатель на поле-секцию заголовка
+using SnapshotSectionField = SnapshotSection SnapshotHeader::*;
+
+// Сборка снимка в памяти и запись в файл
+class SnapshotWriter {
+    public:
+        SnapshotWriter();
+
+        // Запись массива из count элементов в секцию section
+        template <typename T>
+        void WriteSection(SnapshotSectionField section, const T* data, std::size_t count);
+
+        // Запись строк в секции смещений и символов
+        template <typename StringContainer>
+        void WriteStrings(SnapshotSectionField offsets, SnapshotSectionField chars, const StringContainer& strings);
+
+        // Заполнение заголовка и запись файла
+        void Save(const std::string& path);
+
+    private:
+        SnapshotHeader header_;
+        std::vector<std::byte> buffer_;
+};
+
+// Снимок индекса, отображенный в память. Конструктор проверяет заголовок, границы секций
+// и, если verify_checksum, контрольную сумму
+class SnapshotReader {
+    public:
+        explicit SnapshotReader(const std::string& path, bool verify_checksum = true);
+
+        const SnapshotHeader& GetHeader() const;
+
+        // Начало массива секции
+        template <typename T>
+        const T* Section(SnapshotSectionField section) const;
+
+        // Колличество элементов секции
+        std::size_t Count(SnapshotSectionField section) const;
+
+        // Строка index из секций смещений и символов
+        std::string_view String(SnapshotSectionField offsets, SnapshotSectionField chars, std::size_t index) const;
+
+    private:
+        MappedFile file_;
+        const SnapshotHeader* header_;
+
+        // Проверка, что секция лежит внутри файла, выровнена и содержит элементы размера element_size
+        void ValidateSection(SnapshotSectionField section, std::size_t element_size) const;
+
+        // Проверка, что блоки сжатых списков лежат внутри секции их байт
+        void ValidatePostingBlocks() const;
+
+        // Проверка, что смещения не убывают и не выходят за пределы секции данных
+        void ValidateOffsets(SnapshotSectionField offsets, SnapshotSectionField data) const;
+};
+
+// Контрольная сумма FNV-1a
+std::uint64_t ComputeSnapshotChecksum(const std::byte* data, std::size_t size);
+
+// Реализация шаблонных функций
+
+template <typename T>
+void SnapshotWriter::WriteSection(SnapshotSectionField section, const T* data, std::size_t count) {
+    const std::size_t alignment = 8;
+    buffer_.resize((buffer_.size() + alignment - 1) / alignment * alignment);
+
+    (header_.*section).offset = buffer_.size();
+    (header_.*section).count = count;
+
+    const std::size_t byte_count = count * sizeof(T);
+    buffer_.resize(buffer_.size() + byte_count);
+    if (byte_count > 0) {
+        std::memcpy(buffer_.data() + buffer_.size() - byte_count, data, byte_count);
+    }
+}
+
+template <typename StringContainer>
+void SnapshotWriter::WriteStrings(SnapshotSectionField offsets, SnapshotSectionField chars,
+    const StringContainer& strings) {
+    std::vector<std::uint64_t> string_offsets = {0};
+    std::string string_chars;
+    for (std::string_view str : strings) {
+        string_chars += str;
+        string_offsets.push_back(string_chars.size());
+    }
+    WriteSection(offsets, string_offsets.data(), string_offsets.size());
+    WriteSection(chars, string_chars.data(), string_chars.size());
+}
+
+template <typename T>
+const T* SnapshotReader::Section(SnapshotSectionField section) const {
+    return reinterpret_cast<const T*>(file_.data() + (header_->*section).offset);
+}
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "stress_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "concurrent_search_server.h"
+#include "search_server.h"
+#include "top_documents.h"
+
+// Проверка стресс-теста, как и проверки бенчмарков, работает и в сборке с NDEBUG
+#define STRESS_CHECK(condition) CheckStressCondition((condition), #condition, __FILE__, __LINE__)
+
+namespace {
+
+void CheckStressCondition(bool condition, const char* expression, const char* file, int line) {
+    if (!condition) {
+        std::cerr << file << ':' << line << ": stress check failed: " << expression << std::endl;
+        std::abort();
+    }
+}
+
+// Операция считается начатой до вызова сервера и законченной после возврата. Сервер пуст в начале теста,
+// поэтому читатель видит не меньше законченных добавлений без начатых удалений
+// и не больше начатых добавлений без законченных удалений
+struct OperationCounters {
+    std::atomic<int> started_adds{0};
+    std::atomic<int> finished_adds{0};
+    std::atomic<int> started_removals{0};
+    std::atomic<int> finished_removals{0};
+};
+
+// Как может меняться число документов, которое видит один читатель, в пределах фазы
+enum class CountTrend {
+    ANY,
+    NON_DECREASING,
+    NON_INCREASING,
+};
+
+// Документы и запросы теста. Сервер под тестом и эталонный получают одни и те же операции
+struct StressWorkload {
+    std::vector<std::string> documents;
+    std::vector<std::string> readded_documents;
+    std::vector<std::string> queries;
+};
+
+// Добавление и удаление вместе со счетчиками. Эталонный сервер повторяет операции после фазы,
+// поэтому порядок вызовов внутри фазы на итог не влияет
+class StressOperations {
+    public:
+        StressOperations(ConcurrentSearchServer& search_server, OperationCounters& counters)
+            : search_server_(search_server)
+            , counters_(counters) {
+        }
+
+        void AddDocument(int document_id, const std::string& document) {
+            ++counters_.started_adds;
+            search_server_.AddDocument(document_id, document, GetStatus(document_id), GetRatings(document_id));
+            ++counters_.finished_adds;
+        }
+
+        void RemoveDocument(int document_id) {
+            ++counters_.started_removals;
+            search_server_.RemoveDocument(document_id);
+            ++counters_.finished_removals;
+        }
+
+        static DocumentStatus GetStatus(int document_id) {
+            return static_cast<DocumentStatus>(document_id % 4);
+        }
+
+        static std::vector<int> GetRatings(int document_id) {
+            return {document_id % 7, 3, -(document_id % 5)};
+        }
+
+    private:
+        ConcurrentSearchServer& search_server_;
+        OperationCounters& counters_;
+};
+
+// Читатель выполняет запросы, пока идет фаза, и проверяет каждую прочитанную версию индекса
+std::size_t ReadWhileRunning(const ConcurrentSearchServer& search_server, const OperationCounters& counters,
+    const std::vector<std::string>& queries, std::size_t first_query, int document_id_limit, CountTrend trend,
+    const std::atomic<bool>& is_running) {
+
+    std::size_t query_count = 0;
+    int last_document_count = search_server.GetDocumentCount();
+    for (std::size_t i = first_query % queries.size(); is_running; i = (i + 1) % queries.size()) {
+        const int finished_adds = counters.finished_adds;
+        const int finished_removals = counters.finished_removals;
+        const int document_count = search_server.GetDocumentCount();
+        const int started_adds = counters.started_adds;
+        const int started_removals = counters.started_removals;
+        STRESS_CHECK(document_count >= finished_adds - started_removals);
+        STRESS_CHECK(document_count <= started_adds - finished_removals);
+        if (trend == CountTrend::NON_DECREASING) {
+            STRESS_CHECK(document_count >= last_document_count);
+        } else if (trend == CountTrend::NON_INCREASING) {
+            STRESS_CHECK(document_count <= last_document_count);
+        }
+        last_document_count = document_count;
+
+        const std::vector<Document> found = search_server.FindTopDocuments(queries[i],
+            [](int, DocumentStatus status, int) { return status != DocumentStatus::REMOVED; });
+        STRESS_CHECK(found.size() <= MAX_RESULT_DOCUMENT_COUNT);
+        for (std::size_t j = 0; j < found.size(); ++j) {
+            STRESS_CHECK(found[j].id >= 0 && found[j].id < document_id_limit);
+            STRESS_CHECK(j == 0 || !TopDocuments::IsBetter(found[j], found[j - 1]));
+        }
+        ++query_count;
+    }
+    return query_count;
+}
+
+// Фаза теста: рабочие потоки выполняют свои операции, reader_count читателей проверяют индекс,
+// пока рабочие не закончат. Возвращает колличество выполненных запросов
+std::size_t RunStressPhase(const ConcurrentSearchServer& search_server, const OperationCounters& counters,
+    const std::vector<std::string>& queries, int document_id_limit, CountTrend trend, int reader_count,
+    const std::vector<std::function<void()>>& workers) {
+
+    std::atomic<bool> is_running{true};
+    std::vector<std::size_t> query_counts(static_cast<std::size_t>(reader_count), 0);
+    std::vector<std::thread> readers;
+    for (std::size_t reader = 0; reader < query_counts.size(); ++reader) {
+        readers.emplace_back([&, reader] {
+            query_counts[reader] = ReadWhileRunning(search_server, counters, queries, reader, document_id_limit,
+                trend, is_running);
+        });
+    }
+    std::vector<std::thread> worker_threads;
+    for (const auto& worker : workers) {
+        worker_threads.emplace_back(worker);
+    }
+    for (std::thread& worker_thread : worker_threads) {
+        worker_thread.join();
+    }
+    is_running = false;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::size_t query_count = 0;
+    for (const std::size_t reader_query_count : query_counts) {
+        query_count += reader_query_count;
+    }
+    return query_count;
+}
+
+void CheckSameResults(const SearchServer& expected_server, const ConcurrentSearchServer& search_server,
+    const StressWorkload& workload, int document_id_limit) {
+
+    STRESS_CHECK(search_server.GetDocumentCount() == expected_server.GetDocumentCount());
+    const auto by_rating = [](int, DocumentStatus, int rating) { return rating > 0; };
+    for (const std::string& query : workload.queries) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            const std::vector<Document> expected = expected_server.FindTopDocuments(query, status);
+            const std::vector<Document> found = search_server.FindTopDocuments(query, status);
+            STRESS_CHECK(expected.size() == found.size());
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                STRESS_CHECK(expected[i].id == found[i].id);
+                STRESS_CHECK(expected[i].relevance == found[i].relevance);
+                STRESS_CHECK(expected[i].rating == found[i].rating);
+            }
+        }
+        const std::vector<Document> expected = expected_server.FindTopDocuments(query, by_rating);
+        const std::vector<Document> found = search_server.FindTopDocuments(query, by_rating);
+        STRESS_CHECK(expected.size() == found.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            STRESS_CHECK(expected[i].id == found[i].id);
+            STRESS_CHECK(expected[i].relevance == found[i].relevance);
+        }
+    }
+
+    // Удаленные документы не находятся и по ID
+    for (int document_id = 0; document_id < document_id_limit; document_id += 7) {
+        const bool is_expected = std::find(expected_server.begin(), expected_server.end(), document_id)
+            != expected_server.end();
+        try {
+            search_server.MatchDocument(workload.queries.front(), document_id);
+            STRESS_CHECK(is_expected);
+        } catch (const std::out_of_range&) {
+            STRESS_CHECK(!is_expected);
+        }
+    }
+}
+
+} // namespace
+
+// Фазы теста:
+// 1. писатели добавляют первую половину документов, число документов не убывает;
+// 2. писатели добавляют вторую половину, а удаляющие потоки удаляют каждый третий документ первой
+//    половины и часть из них добавляют заново с другим текстом;
+// 3. удаляющие потоки удаляют каждый третий документ второй половины, число документов не растет.
+// Маленький буфер записи и предел сегментов заставляют сервер постоянно сбрасывать буфер и сливать сегменты
+void RunConcurrentStressTest() {
+    const int writer_count = 4;
+    const int remover_count = 3;
+    const int reader_count = 4;
+    const int half_document_count = 3'000;
+    const int document_count = 2 * half_document_count;
+
+    std::mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    StressWorkload workload;
+    workload.documents = GenerateQueries(generator, dictionary, document_count, 30);
+    workload.readded_documents = GenerateQueries(generator, dictionary, document_count, 30);
+    workload.queries = GenerateQueries(generator, dictionary, 300, 6);
+
+    ConcurrentSearchServer search_server(dictionary[0], 64, 3);
+    SearchServer expected_server(dictionary[0]);
+    OperationCounters counters;
+    StressOperations operations(search_server, counters);
+    std::size_t query_count = 0;
+
+    // Писатель writer добавляет каждый writer_count-й документ из [first_id, last_id)
+    const auto make_writers = [&](int first_id, int last_id) {
+        std::vector<std::function<void()>> writers;
+        for (int writer = 0; writer < writer_count; ++writer) {
+            writers.push_back([&, writer, first_id, last_id] {
+                for (int document_id = first_id + writer; document_id < last_id; document_id += writer_count) {
+                    operations.AddDocument(document_id, workload.documents[static_cast<std::size_t>(document_id)]);
+                }
+            });
+        }
+        return writers;
+    };
+    // Удаляющий поток remover удаляет свою долю документов [first_id, last_id) с шагом 3,
+    // документ с ID, кратным 9, сразу добавляется заново
+    const auto make_removers = [&](int first_id, int last_id, bool readd) {
+        std::vector<std::function<void()>> removers;
+        for (int remover = 0; remover < remover_count; ++remover) {
+            removers.push_back([&, remover, first_id, last_id, readd] {
+                for (int document_id = first_id + 3 * remover; document_id < last_id; document_id += 3 * remover_count) {
+                    operations.RemoveDocument(document_id);
+                    if (readd && document_id % 9 == 0) {
+                        operations.AddDocument(document_id,
+                            workload.readded_documents[static_cast<std::size_t>(document_id)]);
+                    }
+                }
+            });
+        }
+        return removers;
+    };
+    const auto apply_expected = [&](int first_id, int last_id, int first_removed_id, int last_removed_id,
+        bool readd) {
+        for (int document_id = first_id; document_id < last_id; ++document_id) {
+            expected_server.AddDocument(document_id, workload.documents[static_cast<std::size_t>(document_id)],
+                StressOperations::GetStatus(document_id), StressOperations::GetRatings(document_id));
+        }
+        for (int document_id = first_removed_id; document_id < last_removed_id; document_id += 3) {
+            expected_server.RemoveDocument(document_id);
+            if (readd && document_id % 9 == 0) {
+                expected_server.AddDocument(document_id,
+                    workload.readded_documents[static_cast<std::size_t>(document_id)],
+                    StressOperations::GetStatus(document_id), StressOperations::GetRatings(document_id));
+            }
+        }
+    };
+
+    query_count += RunStressPhase(search_server, counters, workload.queries, document_count,
+        CountTrend::NON_DECREASING, reader_count, make_writers(0, half_document_count));
+    apply_expected(0, half_document_count, 0, 0, false);
+    CheckSameResults(expected_server, search_server, workload, document_count);
+
+    std::vector<std::function<void()>> workers = make_writers(half_document_count, document_count);
+    for (auto& remover : make_removers(0, half_document_count, true)) {
+        workers.push_back(std::move(remover));
+    }
+    query_count += RunStressPhase(search_server, counters, workload.queries, document_count, CountTrend::ANY,
+        reader_count, workers);
+    apply_expected(half_document_count, document_count, 0, half_document_count, true);
+    CheckSameResults(expected_server, search_server, workload, document_count);
+
+    // Первый ID второй половины, дающий остаток 1 при делении на 3
+    const int first_removed_id = half_document_count + (1 - half_document_count % 3 + 3) % 3;
+    query_count += RunStressPhase(search_server, counters, workload.queries, document_count,
+        CountTrend::NON_INCREASING, reader_count, make_removers(first_removed_id, document_count, false));
+    apply_expected(0, 0, first_removed_id, document_count, false);
+    CheckSameResults(expected_server, search_server, workload, document_count);
+
+    // После сброса буфера и слияний удаленные документы выброшены, а выдача прежняя
+    search_server.Flush();
+    CheckSameResults(expected_server, search_server, workload, document_count);
+
+    std::cerr << "ConcurrentSearchServer stress test: " << counters.finished_adds << " adds, "
+        << counters.finished_removals << " removals, " << query_count << " queries, "
+        << search_server.GetSegmentCount() << " segments after flush, ok" << std::endl;
+}
\ No newline at end of file
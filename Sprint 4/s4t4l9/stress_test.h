@@ -0,0 +1,7 @@
+#pragma once
+
+// Стресс-тест ConcurrentSearchServer: писатели, удаляющие потоки и читатели работают одновременно.
+// Читатели проверяют, что число документов не выходит за границы, заданные законченными
+// и начатыми операциями, и меняется монотонно в фазах только с добавлениями или только с удалениями.
+// В конце выдача сверяется с обычным SearchServer после тех же операций. Нарушение останавливает программу
+void RunConcurrentStressTest();
\ No newline at end of file
@@ -1,23 +1,19 @@
 #include "string_processing.h"
 
+#include <algorithm>
+
 // Разделяем строку на слова, удаляя пробелы
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-    std::vector<std::string> words;
-    std::string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
-        } else {
-            word += c;
-        }
-    }
-    
-    if (!word.empty()) {
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    ForEachWord(text, [&words](std::string_view word) {
         words.push_back(word);
-    }
-
+    });
     return words;
-}
\ No newline at end of file
+}
+
+// Проверка слова на отсутствие управляющих символов
+bool IsValidWord(std::string_view word) {
+    return std::none_of(word.begin(), word.end(), [](char c) {
+        return c >= '\0' && c < ' ';
+        });
+}
@@ -1,18 +1,40 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<std::string> SplitIntoWords(const std::string& text);
+// Обход слов строки без выделения памяти: callback получает каждое слово как string_view
+template <typename Callback>
+void ForEachWord(std::string_view text, Callback callback) {
+    while (!text.empty()) {
+        const std::size_t word_begin = text.find_first_not_of(' ');
+        if (word_begin == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(word_begin);
+        const std::size_t word_end = std::min(text.find(' '), text.size());
+        callback(text.substr(0, word_end));
+        text.remove_prefix(word_end);
+    }
+}
+
+// Разделяем строку на слова, удаляя пробелы. Слова ссылаются на исходную строку
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
+
+// Проверка слова на отсутствие управляющих символов
+bool IsValidWord(std::string_view word);
 
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
-    for (const std::string& str : strings) {
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
+    for (std::string_view str : strings) {
         if (!str.empty()) {
-            non_empty_strings.insert(str);
+            non_empty_strings.emplace(str);
         }
     }
     return non_empty_strings;
-}
\ No newline at end of file
+}
@@ -0,0 +1,133 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+        : term_count_(other.term_count_.load())
+        , block_offsets_(other.block_offsets_)
+        , data_(other.data_) {
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        term_count_.store(other.term_count_.load());
+        block_offsets_ = other.block_offsets_;
+        data_ = other.data_;
+    }
+    return *this;
+}
+
+void TermDictionary::Fill(const std::vector<std::pair<std::string_view, TermId>>& sorted_terms) {
+    block_offsets_.clear();
+    data_.clear();
+    std::string_view previous_term;
+    std::size_t index = 0;
+    for (const auto& [term, term_id] : sorted_terms) {
+        if (index++ % BLOCK_SIZE == 0) {
+            block_offsets_.push_back(data_.size());
+            AppendVarint(static_cast<std::uint32_t>(term.size()));
+            data_.insert(data_.end(), term.begin(), term.end());
+        } else {
+            const auto shared = static_cast<std::size_t>(std::mismatch(previous_term.begin(), previous_term.end(),
+                term.begin(), term.end()).first - previous_term.begin());
+            AppendVarint(static_cast<std::uint32_t>(shared));
+            AppendVarint(static_cast<std::uint32_t>(term.size() - shared));
+            data_.insert(data_.end(), term.begin() + shared, term.end());
+        }
+        AppendVarint(term_id);
+        previous_term = term;
+    }
+}
+
+std::size_t TermDictionary::GetByteSize() const {
+    return block_offsets_.size() * sizeof(std::uint64_t) + data_.size();
+}
+
+std::size_t TermDictionary::FindFirstBlock(std::string_view prefix) const {
+    // Двоичный поиск по первым термам блоков: ищем последний блок, первый терм которого меньше prefix,
+    // как левую границу FindStartsWith
+    std::size_t lower = 0;
+    std::size_t upper = block_offsets_.size();
+    while (lower < upper) {
+        const std::size_t middle = lower + (upper - lower) / 2;
+        std::size_t offset = block_offsets_[middle];
+        const std::size_t size = ReadVarint(offset);
+        const std::string_view head(reinterpret_cast<const char*>(data_.data() + offset), size);
+        if (head < prefix) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+    return lower == 0 ? 0 : lower - 1;
+}
+
+bool TermDictionary::FindFirstTermWithPrefix(std::string_view prefix, std::size_t& index, std::size_t& offset,
+    TermId& term_id) const {
+    const std::size_t term_count = term_count_.load(std::memory_order_acquire);
+    // Термы меньше префикса лежат не дальше чем в двух блоках, их собираем целиком
+    std::string term;
+    for (index = FindFirstBlock(prefix) * BLOCK_SIZE; index < term_count; ++index) {
+        const bool is_block_head = index % BLOCK_SIZE == 0;
+        if (is_block_head) {
+            offset = block_offsets_[index / BLOCK_SIZE];
+        }
+        term_id = ReadTerm(offset, is_block_head, term);
+        if (term >= prefix) {
+            return term.compare(0, prefix.size(), prefix) == 0;
+        }
+    }
+    return false;
+}
+
+bool TermDictionary::ReadNextTermWithPrefix(std::string_view prefix, std::size_t& index, std::size_t& offset,
+    TermId& term_id) const {
+    if (++index == term_count_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::size_t size = 0;
+    if (index % BLOCK_SIZE == 0) {
+        offset = block_offsets_[index / BLOCK_SIZE];
+        size = ReadVarint(offset);
+        if (std::string_view(reinterpret_cast<const char*>(data_.data() + offset), size).substr(0, prefix.size())
+            != prefix) {
+            return false;
+        }
+    } else {
+        if (ReadVarint(offset) < prefix.size()) {
+            return false;
+        }
+        size = ReadVarint(offset);
+    }
+    offset += size;
+    term_id = ReadVarint(offset);
+    return true;
+}
+
+TermId TermDictionary::ReadTerm(std::size_t& offset, bool is_block_head, std::string& term) const {
+    const std::size_t shared = is_block_head ? 0 : ReadVarint(offset);
+    const std::size_t suffix_size = ReadVarint(offset);
+    term.resize(shared);
+    term.append(reinterpret_cast<const char*>(data_.data() + offset), suffix_size);
+    offset += suffix_size;
+    return ReadVarint(offset);
+}
+
+std::uint32_t TermDictionary::ReadVarint(std::size_t& offset) const {
+    std::uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        const std::uint8_t byte = data_[offset++];
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+void TermDictionary::AppendVarint(std::uint32_t value) {
+    while (value >= 0x80) {
+        data_.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data_.push_back(static_cast<std::uint8_t>(value));
+}
\ No newline at end of file
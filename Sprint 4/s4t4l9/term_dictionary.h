@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "posting_list.h"
+
+// Отсортированный словарь термов с фронтальным кодированием для поиска по префиксу.
+// Термы хранятся блоками по BLOCK_SIZE: первый терм блока записан целиком, у остальных
+// записаны длина общего с предыдущим термом начала и оставшийся хвост. Блоки лежат в одном
+// массиве, поэтому диапазон термов с префиксом читается подряд, без обхода узлов std::map.
+// Словарь собирается по словарю SearchServer при первом поиске по префиксу после появления
+// новых термов. Сборка защищена мьютексом, поэтому ее можно запускать из константных методов поиска
+class TermDictionary {
+    public:
+        static constexpr std::size_t BLOCK_SIZE = 16;
+
+        TermDictionary() = default;
+
+        TermDictionary(const TermDictionary& other);
+
+        TermDictionary& operator=(const TermDictionary& other);
+
+        // Сборка, если в terms появились термы, которых нет в словаре. ID терма - его индекс в terms,
+        // термы не повторяются. Термы из словаря не удаляются
+        template <typename Terms>
+        void RefreshIfStale(const Terms& terms);
+
+        // Обход ID термов, начинающихся с prefix, по возрастанию термов.
+        // callback(term_id) возвращает false, чтобы остановить обход
+        template <typename Callback>
+        void ForEachTermWithPrefix(std::string_view prefix, Callback callback) const;
+
+        // Объем словаря в байтах
+        std::size_t GetByteSize() const;
+
+    private:
+        std::mutex mutex_;
+        std::atomic<std::size_t> term_count_{0};
+        // Начало каждого блока в data_
+        std::vector<std::uint64_t> block_offsets_;
+        std::vector<std::uint8_t> data_;
+
+        // Запись термов, отсортированных по возрастанию, вызывается под мьютексом
+        void Fill(const std::vector<std::pair<std::string_view, TermId>>& sorted_terms);
+
+        // Первый блок, в котором могут быть термы не меньше prefix
+        std::size_t FindFirstBlock(std::string_view prefix) const;
+
+        // Первый терм с префиксом: его номер index, ID и начало следующего терма offset.
+        // false, если таких термов нет
+        bool FindFirstTermWithPrefix(std::string_view prefix, std::size_t& index, std::size_t& offset,
+            TermId& term_id) const;
+
+        // Переход к следующему терму, false, если у него нет префикса. Терм внутри блока имеет префикс,
+        // только если общее с предыдущим термом начало не короче префикса, поэтому сам терм не собирается
+        bool ReadNextTermWithPrefix(std::string_view prefix, std::size_t& index, std::size_t& offset,
+            TermId& term_id) const;
+
+        // Чтение терма с позиции offset: term хранит предыдущий терм блока и заменяется текущим
+        TermId ReadTerm(std::size_t& offset, bool is_block_head, std::string& term) const;
+
+        std::uint32_t ReadVarint(std::size_t& offset) const;
+
+        void AppendVarint(std::uint32_t value);
+};
+
+// Реализация шаблонных функций
+
+template <typename Terms>
+void TermDictionary::RefreshIfStale(const Terms& terms) {
+    if (term_count_.load(std::memory_order_acquire) == terms.size()) {
+        return;
+    }
+    std::lock_guard guard(mutex_);
+    // Пока ждали мьютекс, словарь мог собрать другой поток
+    if (term_count_.load(std::memory_order_relaxed) == terms.size()) {
+        return;
+    }
+    std::vector<std::pair<std::string_view, TermId>> sorted_terms;
+    sorted_terms.reserve(terms.size());
+    for (std::size_t term_id = 0; term_id < terms.size(); ++term_id) {
+        sorted_terms.push_back({terms[term_id], static_cast<TermId>(term_id)});
+    }
+    std::sort(sorted_terms.begin(), sorted_terms.end());
+    Fill(sorted_terms);
+    term_count_.store(terms.size(), std::memory_order_release);
+}
+
+template <typename Callback>
+void TermDictionary::ForEachTermWithPrefix(std::string_view prefix, Callback callback) const {
+    std::size_t index = 0;
+    std::size_t offset = 0;
+    TermId term_id = 0;
+    bool has_term = FindFirstTermWithPrefix(prefix, index, offset, term_id);
+    while (has_term && callback(term_id)) {
+        has_term = ReadNextTermWithPrefix(prefix, index, offset, term_id);
+    }
+}
\ No newline at end of file
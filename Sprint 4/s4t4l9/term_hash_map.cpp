@@ -0,0 +1,71 @@
+#include "term_hash_map.h"
+
+#include <algorithm>
+#include <functional>
+
+TermId TermHashMap::Find(std::string_view term) const {
+    if (slots_.empty()) {
+        return NO_TERM_ID;
+    }
+    return slots_[FindSlot(term, Hash(term))].term_id;
+}
+
+TermId TermHashMap::Emplace(std::string_view term, TermId term_id) {
+    // Заполнено не больше половины ячеек, поэтому цепочки пробирования короткие
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+    }
+    const std::uint64_t hash = Hash(term);
+    Slot& slot = slots_[FindSlot(term, hash)];
+    if (slot.term_id == NO_TERM_ID) {
+        slot = {term, static_cast<std::uint32_t>(hash >> 32), term_id};
+        ++size_;
+    }
+    return slot.term_id;
+}
+
+void TermHashMap::Reserve(std::size_t term_count) {
+    std::size_t slot_count = 16;
+    while (slot_count < term_count * 2) {
+        slot_count *= 2;
+    }
+    if (slot_count > slots_.size()) {
+        Rehash(slot_count);
+    }
+}
+
+std::size_t TermHashMap::size() const {
+    return size_;
+}
+
+std::uint64_t TermHashMap::Hash(std::string_view term) {
+    return std::hash<std::string_view>{}(term);
+}
+
+std::size_t TermHashMap::FindSlot(std::string_view term, std::uint64_t hash) const {
+    // Размер таблицы - степень двойки, поэтому остаток заменяется маской
+    const std::size_t mask = slots_.size() - 1;
+    const auto high_hash = static_cast<std::uint32_t>(hash >> 32);
+    std::size_t pos = hash & mask;
+    while (slots_[pos].term_id != NO_TERM_ID && (slots_[pos].hash != high_hash || slots_[pos].term != term)) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void TermHashMap::Rehash(std::size_t slot_count) {
+    std::vector<Slot> old_slots(slot_count);
+    old_slots.swap(slots_);
+    const std::size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old_slots) {
+        if (slot.term_id == NO_TERM_ID) {
+            continue;
+        }
+        // Слова в таблице не повторяются, поэтому достаточно найти свободную ячейку
+        std::size_t pos = Hash(slot.term) & mask;
+        while (slots_[pos].term_id != NO_TERM_ID) {
+            pos = (pos + 1) & mask;
+        }
+        slots_[pos] = slot;
+    }
+}
\ No newline at end of file
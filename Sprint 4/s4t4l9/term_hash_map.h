@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "posting_list.h"
+
+// ID слова, которого нет в словаре
+constexpr TermId NO_TERM_ID = std::numeric_limits<TermId>::max();
+
+// Словарь термов SearchServer: слово -> плотный ID терма. Открытая адресация с линейным пробированием
+// в одном массиве: поиск слова - вычисление хэша и сравнение с несколькими соседними ячейками,
+// без обхода узлов дерева. Строки словарь не хранит, ключи ссылаются на хранилище термов владельца
+class TermHashMap {
+    public:
+        // ID слова или NO_TERM_ID
+        TermId Find(std::string_view term) const;
+
+        // ID слова. Нового слова в словаре нет, оно добавляется с ID term_id.
+        // Строка term должна жить не меньше словаря
+        TermId Emplace(std::string_view term, TermId term_id);
+
+        // Резерв ячеек под term_count слов, чтобы их добавление обошлось без перестроений
+        void Reserve(std::size_t term_count);
+
+        std::size_t size() const;
+
+    private:
+        struct Slot {
+            std::string_view term;
+            // Старшие биты хэша: ячейки с другими словами отсеиваются без сравнения строк
+            std::uint32_t hash = 0;
+            TermId term_id = NO_TERM_ID;
+        };
+
+        std::vector<Slot> slots_;
+        std::size_t size_ = 0;
+
+        static std::uint64_t Hash(std::string_view term);
+
+        // Ячейка слова или пустая ячейка, в которую его можно добавить
+        std::size_t FindSlot(std::string_view term, std::uint64_t hash) const;
+
+        // Перестроение таблицы на slot_count ячеек
+        void Rehash(std::size_t slot_count);
+};
\ No newline at end of file
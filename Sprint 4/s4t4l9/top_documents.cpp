@@ -0,0 +1,90 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+TopDocuments::TopDocuments(std::size_t max_count)
+        : max_count_(max_count) {
+    heap_.reserve(max_count_);
+}
+
+TopDocuments::TopDocuments(Document* storage, std::size_t max_count)
+        : max_count_(max_count)
+        , storage_(storage) {
+}
+
+std::size_t TopDocuments::GetMaxCount() const {
+    return max_count_;
+}
+
+bool TopDocuments::IsBetter(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
+        // При равных релевантности и рейтинге порядок фиксируется по ID
+        if (lhs.rating == rhs.rating) {
+            return lhs.id < rhs.id;
+        }
+        return lhs.rating > rhs.rating;
+    } else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+double TopDocuments::GetMinRelevanceToEnter() const {
+    if (max_count_ == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (size_ < max_count_) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    // Документ ближе RELEVANCE_EPSILON к худшему может обойти его по рейтингу
+    return GetHeap()[0].relevance - 2 * RELEVANCE_EPSILON;
+}
+
+void TopDocuments::Push(const Document& document) {
+    if (max_count_ == 0) {
+        return;
+    }
+    if (size_ < max_count_) {
+        if (storage_ == nullptr) {
+            heap_.push_back(document);
+        } else {
+            storage_[size_] = document;
+        }
+        ++size_;
+        std::push_heap(GetHeap(), GetHeap() + size_, IsBetter);
+        return;
+    }
+    Document* heap = GetHeap();
+    if (IsBetter(document, heap[0])) {
+        std::pop_heap(heap, heap + size_, IsBetter);
+        heap[size_ - 1] = document;
+        std::push_heap(heap, heap + size_, IsBetter);
+    }
+}
+
+std::vector<Document> TopDocuments::Extract() {
+    std::sort_heap(GetHeap(), GetHeap() + size_, IsBetter);
+    if (storage_ != nullptr) {
+        return {storage_, storage_ + std::exchange(size_, 0)};
+    }
+    size_ = 0;
+    return std::exchange(heap_, {});
+}
+
+std::size_t TopDocuments::ExtractToStorage() {
+    if (storage_ == nullptr) {
+        throw std::logic_error("TopDocuments has no external storage");
+    }
+    std::sort_heap(storage_, storage_ + size_, IsBetter);
+    return std::exchange(size_, 0);
+}
+
+Document* TopDocuments::GetHeap() {
+    return storage_ != nullptr ? storage_ : heap_.data();
+}
+
+const Document* TopDocuments::GetHeap() const {
+    return storage_ != nullptr ? storage_ : heap_.data();
+}
\ No newline at end of file
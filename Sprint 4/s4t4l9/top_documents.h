@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "document.h"
+
+// Потоковый отбор лучших документов: в памяти хранится не больше max_count кандидатов.
+// Худший из отобранных лежит на вершине кучи и вытесняется более релевантным документом
+class TopDocuments {
+    public:
+        // Релевантности, отличающиеся меньше чем на RELEVANCE_EPSILON, считаются равными
+        static constexpr double RELEVANCE_EPSILON = 1e-6;
+
+        explicit TopDocuments(std::size_t max_count);
+
+        // Отбор прямо в участок памяти [storage, storage + max_count) вызывающего кода без своего вектора.
+        // Участок должен пережить объект
+        TopDocuments(Document* storage, std::size_t max_count);
+
+        // Максимальное колличество документов в выдаче
+        std::size_t GetMaxCount() const;
+
+        // Документ lhs должен стоять в выдаче раньше rhs
+        static bool IsBetter(const Document& lhs, const Document& rhs);
+
+        // Документ с релевантностью ниже этой границы точно не попадет в топ при любом рейтинге и ID.
+        // Пока топ не заполнен, граница - минус бесконечность. Граница взята с запасом
+        // на погрешность округления, поэтому по ней можно отсекать документы по верхней оценке
+        double GetMinRelevanceToEnter() const;
+
+        // Предложить документ кандидатом в топ
+        void Push(const Document& document);
+
+        // Отобранные документы по убыванию релевантности, объект после вызова пуст
+        std::vector<Document> Extract();
+
+        // Упорядочить отобранные документы по убыванию релевантности в начале участка storage
+        // и вернуть их колличество, объект после вызова пуст. Только для отбора во внешний участок
+        std::size_t ExtractToStorage();
+
+    private:
+        Document* GetHeap();
+
+        const Document* GetHeap() const;
+
+        std::size_t max_count_;
+        // Внешний участок под кучу или nullptr, если куча лежит в heap_
+        Document* storage_ = nullptr;
+        std::size_t size_ = 0;
+        std::vector<Document> heap_;
+};
\ No newline at end of file